@@ -0,0 +1,262 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// batch_runner.h - Simulation of many task files in one process.
+// RunOptions & runTaskFile: the single-file run shared by the driver &
+//                           every batch job
+// WorkStealingPool: fixed set of threads, each draining its own deque of
+//                   jobs & stealing from the back of the others' once empty
+// runBatch: one independent run per task file, outputs written to their
+//           own files or merged in input order
+//
+
+#ifndef BATCH_RUNNER_H_
+#define BATCH_RUNNER_H_
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cfs_sched.h"
+#include "smp_sched.h"
+
+// RunOptions - how a task file is simulated & reported
+struct RunOptions {
+  // Jump the clock from event to event
+  bool fast_forward = false;
+  // One line per run of ticks instead of per tick
+  bool ranges = false;
+  // # of simulated CPUs, 0 for the per-tick uniprocessor output
+  unsigned int cpus = 0;
+  // Print latency & fairness to std::cerr at the end of a uniprocessor
+  // run, & every latency_every ticks if nonzero
+  bool latency = false;
+  uint64_t latency_every = 0;
+  // # of leftmost waiting tasks listed after each periodic report
+  unsigned int top = 0;
+};
+
+// runTasks - run @tasks with @options, reporting to @sink, or printing
+//            the per-CPU summary to @os when simulating several CPUs;
+//            return the uniprocessor run's totals, empty for several CPUs
+inline RunStats runTasks(TaskSource& tasks, StatusSink& sink,
+                         std::ostream& os, const RunOptions& options) {
+  if (options.cpus) {
+    runSMP(tasks, options.cpus, os);
+    return RunStats();
+  }
+  if (options.latency) {
+    LatencyStats latency(std::cerr, options.latency_every);
+    return runCFS(tasks, sink, options.fast_forward, &latency, options.top);
+  }
+  return runCFS(tasks, sink, options.fast_forward);
+}
+
+// runTaskFile - load, order & run the tasks in @file_name with @options,
+//               writing output to @os; throws if the file cannot be
+//               loaded, else returns the run's totals
+inline RunStats runTaskFile(const char *file_name, std::ostream& os,
+                            const RunOptions& options) {
+  std::vector<Task> task_list;
+  TaskGroups groups;
+  TaskBursts bursts;
+  loadTasks(task_list, file_name, &groups, &bursts);
+  organizeTasks(task_list);
+
+  TaskListSource tasks(task_list, &groups, &bursts);
+  if (options.ranges) {
+    RunLengthSink sink(os);
+    return runTasks(tasks, sink, os, options);
+  }
+  TextSink sink(os);
+  return runTasks(tasks, sink, os, options);
+}
+
+// WorkStealingPool - run jobs over a fixed # of threads
+class WorkStealingPool {
+ public:
+    // WorkStealingPool() - @threads workers, 0 for one per hardware thread
+    explicit WorkStealingPool(unsigned int threads = 0) :
+        n_workers(threads ? threads :
+                  std::max(1u, std::thread::hardware_concurrency())) {}
+
+    // getWorkers - return # of worker threads
+    unsigned int getWorkers(void) const {
+      return n_workers;
+    }
+
+    // Run - call @job(i) for every i in [0, @n) & return once all finish
+    void Run(std::size_t n, const std::function<void(std::size_t)>& job) {
+      std::vector<Worker> workers(n_workers);
+      // Deal jobs round-robin so each deque starts with its share
+      for (std::size_t i = 0; i < n; i++)
+        workers[i % n_workers].jobs.push_back(i);
+
+      std::vector<std::thread> threads;
+      for (unsigned int w = 0; w < n_workers; w++)
+        threads.emplace_back([&workers, &job, w] {
+          std::size_t i;
+          while (Take(workers, w, &i))
+            job(i);
+        });
+      for (auto& thread : threads)
+        thread.join();
+    }
+
+ private:
+    // Worker - one thread's deque of pending job indices
+    struct Worker {
+      std::mutex lock;
+      std::deque<std::size_t> jobs;
+    };
+
+    unsigned int n_workers;
+
+    // Take - pop the front of worker @w's deque, else steal from the back
+    //        of another's; return false once every deque is empty
+    static bool Take(std::vector<Worker>& workers, unsigned int w,
+                     std::size_t *i) {
+      for (std::size_t k = 0; k < workers.size(); k++) {
+        Worker& victim = workers[(w + k) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.jobs.empty())
+          continue;
+        if (k == 0) {
+          *i = victim.jobs.front();
+          victim.jobs.pop_front();
+        } else {
+          *i = victim.jobs.back();
+          victim.jobs.pop_back();
+        }
+        return true;
+      }
+      // Jobs never spawn jobs, so an empty sweep means all are taken
+      return false;
+    }
+};
+
+// listWorkloads - return the task files named in @path: every *.dat file
+//                 of a directory in name order, or one path per line of
+//                 a list file
+inline std::vector<std::string> listWorkloads(const std::string& path) {
+  std::vector<std::string> files;
+  if (DIR *dir = opendir(path.c_str())) {
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name(entry->d_name);
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".dat") == 0)
+        files.push_back(path + "/" + name);
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  std::ifstream list(path);
+  if (!list.is_open())
+    throw std::runtime_error("cannot open file " + path);
+  std::string line;
+  while (std::getline(list, line))
+    if (!line.empty())
+      files.push_back(line);
+  return files;
+}
+
+// outputName - return path of the output for task file @file under
+//              @out_dir, its base name with .dat replaced by .out
+inline std::string outputName(const std::string& out_dir,
+                              const std::string& file) {
+  std::string base = file.substr(file.find_last_of('/') + 1);
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".dat") == 0)
+    base.resize(base.size() - 4);
+  return out_dir + "/" + base + ".out";
+}
+
+// BatchResult - outcome of a batch
+struct BatchResult {
+  std::size_t workloads = 0;
+  std::size_t failed = 0;
+  double seconds = 0;
+};
+
+// runBatch - run every task file in @files with @options on @pool; each
+//            output goes to its own file under @out_dir or, if @out_dir
+//            is empty, to @os in input order behind a "==> file <=="
+//            header; load errors are reported to @err
+inline BatchResult runBatch(const std::vector<std::string>& files,
+                            const RunOptions& options,
+                            const std::string& out_dir,
+                            WorkStealingPool& pool,
+                            std::ostream& os = std::cout,
+                            std::ostream& err = std::cerr) {
+  BatchResult result;
+  result.workloads = files.size();
+
+  // Merged outputs are held only until every earlier one is written
+  std::mutex lock;
+  std::vector<std::unique_ptr<std::string>> outputs(files.size());
+  std::vector<std::string> errors(files.size());
+  std::vector<bool> finished(files.size(), false);
+  std::size_t next_output = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  pool.Run(files.size(), [&](std::size_t i) {
+    std::string error;
+    std::unique_ptr<std::string> output;
+    try {
+      if (out_dir.empty()) {
+        std::ostringstream buffer;
+        runTaskFile(files[i].c_str(), buffer, options);
+        output.reset(new std::string(buffer.str()));
+      } else {
+        std::ofstream out(outputName(out_dir, files[i]));
+        if (!out.is_open())
+          throw std::runtime_error("cannot write " +
+                                   outputName(out_dir, files[i]));
+        runTaskFile(files[i].c_str(), out, options);
+      }
+    } catch (const TaskParseError& e) {
+      error = files[i] + ":" + e.what();
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+
+    // Write out every finished result at the front of the input order
+    std::lock_guard<std::mutex> guard(lock);
+    outputs[i] = std::move(output);
+    errors[i] = error;
+    finished[i] = true;
+    while (next_output < files.size() && finished[next_output]) {
+      if (!errors[next_output].empty()) {
+        err << "Error: " << errors[next_output] << '\n';
+        result.failed++;
+      } else if (outputs[next_output]) {
+        os << "==> " << files[next_output] << " <==\n" <<
+          *outputs[next_output];
+      }
+      outputs[next_output].reset();
+      next_output++;
+    }
+  });
+  os.flush();
+  err.flush();
+
+  result.seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+#endif  // BATCH_RUNNER_H_
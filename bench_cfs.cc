@@ -0,0 +1,134 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// bench_cfs.cc - End-to-end macrobenchmark of the CFS scheduler.
+// Loads each task file, runs it to completion with all status lines
+// discarded & prints one line of throughput per file: simulated ticks
+// & dispatches per second of scheduling, load & run wall time, heap
+// allocator calls per simulated tick during the run, and the peak
+// resident set size of the process so far. Run one file per
+// process for a per-file peak. With --latency, latency histograms are
+// recorded too & their final report is printed after the line.
+//
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cfs_sched.h"
+
+// Heap allocator calls made since program start, counted by replacing
+// the global operator new/delete for this binary
+static uint64_t heap_calls = 0;
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  heap_calls++;
+  if (void *p = std::malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  if (p)
+    heap_calls++;
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  operator delete(p);
+}
+
+// usage - print command-line usage & exit
+void usage(char *prog) {
+  std::cerr << "Usage: " << prog << " [--fast-forward] [--latency]"
+    " <task_file.dat>..." << std::endl;
+  exit(1);
+}
+
+// peakRSS - return the peak resident set size of this process in MiB
+double peakRSS(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in KiB on Linux
+  return usage.ru_maxrss / 1024.0;
+}
+
+// seconds - return seconds elapsed since @start
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+// benchFile - load & run @file_name, printing its results; return false
+//             if it could not be loaded
+bool benchFile(const char *file_name, bool fast_forward, bool latency) {
+  std::vector<Task> task_list;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    loadTasks(task_list, file_name);
+  } catch (const TaskParseError& e) {
+    std::cerr << "Error: " << file_name << ":" << e.what() << std::endl;
+    return false;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return false;
+  }
+  organizeTasks(task_list);
+  double load_time = seconds(start);
+
+  NullSink sink;
+  std::ostringstream report;
+  LatencyStats stats_latency(report);
+  uint64_t heap_start = heap_calls;
+  start = std::chrono::steady_clock::now();
+  RunStats stats = runCFS(task_list, sink, fast_forward,
+                          latency ? &stats_latency : nullptr);
+  double run_time = seconds(start);
+  uint64_t run_heap_calls = heap_calls - heap_start;
+
+  std::cout << std::fixed << std::setprecision(3) << file_name <<
+    ": tasks " << task_list.size() << " ticks " << stats.ticks <<
+    " dispatches " << stats.dispatches << " load " << load_time <<
+    " s run " << run_time << " s ticks/s " <<
+    std::setprecision(0) << stats.ticks / run_time << " dispatches/s " <<
+    stats.dispatches / run_time << " heap_calls/tick " <<
+    std::setprecision(4) << static_cast<double>(run_heap_calls) /
+    stats.ticks << " peak_rss " << std::setprecision(1) <<
+    peakRSS() << " MiB" << std::endl << report.str();
+  return true;
+}
+
+// Main method
+int main(int argc, char *argv[]) {
+  bool fast_forward = false;
+  bool latency = false;
+  std::vector<char*> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "--fast-forward")
+      fast_forward = true;
+    else if (arg == "--latency")
+      latency = true;
+    else if (arg.compare(0, 2, "--") == 0)
+      usage(argv[0]);
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.empty())
+    usage(argv[0]);
+
+  int status = 0;
+  for (auto file_name : files)
+    if (!benchFile(file_name, fast_forward, latency))
+      status = 1;
+  return status;
+}
@@ -0,0 +1,541 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// bench_multimap.cc - Microbenchmarks for multimap.h & map.h
+// Reports ns/op along with heap allocator calls per operation, counted
+// by replacing the global operator new/delete for this binary. Timeline
+// workloads also run on std::multimap & std::priority_queue as baselines;
+// `make bench_json` records every result as JSON
+//
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "map.h"
+#include "multimap.h"
+
+// Heap allocator calls made since program start
+static uint64_t heap_calls = 0;
+
+// Replacements are kept out of line so GCC does not pair the inlined
+// malloc/free against the new/delete expressions in the trees
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  heap_calls++;
+  if (void *p = std::malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  if (p)
+    heap_calls++;
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  operator delete(p);
+}
+
+// NextKey - small deterministic LCG so every run churns the same keys
+static inline int NextKey(uint32_t &seed) {
+  seed = seed * 1664525u + 1013904223u;
+  return static_cast<int>(seed >> 8);
+}
+
+// ReportHeapCalls - attach allocator calls per iteration to @state
+static void ReportHeapCalls(benchmark::State &state, uint64_t calls) {
+  state.counters["heap_calls/op"] =
+    benchmark::Counter(calls, benchmark::Counter::kAvgIterations);
+}
+
+// ResidentBytes - return current resident set size of this process
+static int64_t ResidentBytes(void) {
+  long pages = 0, resident = 0;
+  FILE *statm = std::fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    std::fclose(statm);
+  }
+  return static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+// BM_TimelineFootprint - resident bytes per task of a scheduler-shaped
+//                        timeline holding state.range(0) distinct keys
+struct Task;
+static void BM_TimelineFootprint(benchmark::State &state) {
+  for (auto _ : state) {
+    int64_t before = ResidentBytes();
+    Multimap<int, Task*, PoolAllocator> timeline;
+    for (int64_t i = 0; i < state.range(0); i++)
+      timeline.Insert(static_cast<int>(i), nullptr);
+    state.counters["rss_bytes/task"] =
+      static_cast<double>(ResidentBytes() - before) / state.range(0);
+  }
+}
+
+// BM_MultimapChurn - scheduler pattern on a tree of state.range(0) keys:
+//                    remove the minimum, insert a larger random key;
+//                    keys climb ~2^19 per iteration, so they are 64-bit
+template <template <typename> class Alloc>
+static void BM_MultimapChurn(benchmark::State &state) {
+  Multimap<int64_t, int, Alloc> multimap;
+  uint32_t seed = 42;
+  int64_t base = 0;
+  for (int64_t i = 0; i < state.range(0); i++)
+    multimap.Insert(NextKey(seed) % (1 << 20), 0);
+
+  uint64_t start = heap_calls;
+  for (auto _ : state) {
+    base = multimap.Min();
+    multimap.Remove(base);
+    multimap.Insert(base + NextKey(seed) % (1 << 20), 0);
+  }
+  ReportHeapCalls(state, heap_calls - start);
+}
+
+// BM_MapChurn - remove & reinsert random unique keys in a full map
+template <template <typename> class Alloc>
+static void BM_MapChurn(benchmark::State &state) {
+  Map<int, int, Alloc> map;
+  const int64_t n = state.range(0);
+  for (int64_t i = 0; i < n; i++)
+    map.Insert(static_cast<int>(i * 2), 0);
+
+  uint32_t seed = 7;
+  uint64_t start = heap_calls;
+  for (auto _ : state) {
+    // Swap an even key for its odd neighbour & back
+    int key = static_cast<int>((NextKey(seed) % n) * 2);
+    int off = map.Contains(key) ? 0 : 1;
+    map.Remove(key + off);
+    map.Insert(key + (1 - off), 0);
+  }
+  ReportHeapCalls(state, heap_calls - start);
+}
+
+// Multimap counting rotations through its stats policy
+typedef Multimap<int, int, PoolAllocator, 1, CountingTreeStats>
+  CountingMultimap;
+
+// BM_MultimapRemove - delete every key of a tree of state.range(0) random
+//                     keys in random order; reports rotations per insert
+//                     & per delete next to the delete latency
+static void BM_MultimapRemove(benchmark::State &state) {
+  const int64_t n = state.range(0);
+  std::vector<int> keys(n);
+  uint32_t seed = 11;
+  for (auto &key : keys)
+    key = NextKey(seed);
+  std::vector<int> order(keys);
+  std::shuffle(order.begin(), order.end(), std::mt19937(5));
+
+  uint64_t insert_rotations = 0, delete_rotations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    CountingMultimap *multimap = new CountingMultimap;
+    for (auto key : keys)
+      multimap->Insert(key, 0);
+    uint64_t rotations = multimap->GetStats().Rotations();
+    insert_rotations += rotations;
+    state.ResumeTiming();
+
+    for (auto key : order)
+      multimap->Remove(key);
+
+    state.PauseTiming();
+    delete_rotations += multimap->GetStats().Rotations() - rotations;
+    delete multimap;
+    state.ResumeTiming();
+  }
+  double ops = static_cast<double>(state.iterations() * n);
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["rot/insert"] = insert_rotations / ops;
+  state.counters["rot/delete"] = delete_rotations / ops;
+}
+
+// Key of the queue adapters; churn reinserts each minimum up to 2^20
+// higher, so keys are 64-bit to keep long runs from overflowing
+typedef int64_t QueueKey;
+
+// TreeQueue - timeline operations on a Multimap with pooled nodes, as
+//             the scheduler uses it
+struct TreeQueue {
+  Multimap<QueueKey, int, PoolAllocator> tree;
+
+  void Insert(QueueKey key) {
+    tree.Insert(key, static_cast<int>(key));
+  }
+
+  void Insert(QueueKey key, int value) {
+    tree.Insert(key, value);
+  }
+
+  // Move - remove the pair (@key, @value) & insert @value at @new_key
+  void Move(QueueKey key, int value, QueueKey new_key) {
+    tree.Remove(key, value);
+    tree.Insert(new_key, value);
+  }
+
+  QueueKey PopMin(void) {
+    QueueKey key = tree.Min();
+    tree.PopMin();
+    return key;
+  }
+
+  bool Contains(QueueKey key) {
+    return tree.Contains(key);
+  }
+
+  int Get(QueueKey key) {
+    return tree.Get(key);
+  }
+
+  QueueKey Min(void) {
+    return tree.Min();
+  }
+
+  QueueKey Max(void) {
+    return tree.Max();
+  }
+};
+
+// StdMultimapQueue - the same operations on std::multimap
+struct StdMultimapQueue {
+  std::multimap<QueueKey, int> tree;
+
+  void Insert(QueueKey key) {
+    tree.emplace(key, static_cast<int>(key));
+  }
+
+  void Insert(QueueKey key, int value) {
+    tree.emplace(key, value);
+  }
+
+  void Move(QueueKey key, int value, QueueKey new_key) {
+    auto range = tree.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == value) {
+        tree.erase(it);
+        break;
+      }
+    }
+    tree.emplace(new_key, value);
+  }
+
+  QueueKey PopMin(void) {
+    auto first = tree.begin();
+    QueueKey key = first->first;
+    tree.erase(first);
+    return key;
+  }
+
+  bool Contains(QueueKey key) {
+    return tree.find(key) != tree.end();
+  }
+
+  int Get(QueueKey key) {
+    return tree.find(key)->second;
+  }
+
+  QueueKey Min(void) {
+    return tree.begin()->first;
+  }
+
+  QueueKey Max(void) {
+    return tree.rbegin()->first;
+  }
+};
+
+// HeapQueue - min-heap on std::priority_queue, which has no lookups or
+//             Max
+struct HeapQueue {
+  std::priority_queue<QueueKey, std::vector<QueueKey>,
+                      std::greater<QueueKey>> heap;
+
+  void Insert(QueueKey key) {
+    heap.push(key);
+  }
+
+  QueueKey PopMin(void) {
+    QueueKey key = heap.top();
+    heap.pop();
+    return key;
+  }
+
+  QueueKey Min(void) {
+    return heap.top();
+  }
+};
+
+// Distinct keys in the heavy-duplicate workload
+static const int kDuplicateKeys = 16;
+
+// randomKeys - @n keys from the LCG seeded with @seed
+static std::vector<QueueKey> randomKeys(int64_t n, uint32_t seed) {
+  std::vector<QueueKey> keys(n);
+  for (auto &key : keys)
+    key = NextKey(seed);
+  return keys;
+}
+
+// fill - queue holding every key of @keys
+template <typename Q>
+static Q* fill(const std::vector<QueueKey> &keys) {
+  Q *queue = new Q;
+  for (auto key : keys)
+    queue->Insert(key);
+  return queue;
+}
+
+// BM_InsertRandom - build & free a container of state.range(0) random
+//                   keys
+template <typename Q>
+static void BM_InsertRandom(benchmark::State &state) {
+  std::vector<QueueKey> keys = randomKeys(state.range(0), 1);
+  uint64_t start = heap_calls;
+  for (auto _ : state)
+    delete fill<Q>(keys);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["heap_calls/key"] = benchmark::Counter(
+    static_cast<double>(heap_calls - start) / state.range(0),
+    benchmark::Counter::kAvgIterations);
+}
+
+// BM_InsertSequential - build & free a container of state.range(0)
+//                       ascending keys, the worst case for rebalancing
+template <typename Q>
+static void BM_InsertSequential(benchmark::State &state) {
+  std::vector<QueueKey> keys(state.range(0));
+  for (std::size_t i = 0; i < keys.size(); i++)
+    keys[i] = static_cast<QueueKey>(i);
+  for (auto _ : state)
+    delete fill<Q>(keys);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_PopMinChurn - scheduler pattern on state.range(0) keys: pop the
+//                  minimum & insert it again further right
+template <typename Q>
+static void BM_PopMinChurn(benchmark::State &state) {
+  std::unique_ptr<Q> queue(fill<Q>(randomKeys(state.range(0), 2)));
+  uint32_t seed = 42;
+  uint64_t start = heap_calls;
+  for (auto _ : state) {
+    QueueKey key = queue->PopMin();
+    queue->Insert(key + NextKey(seed) % (1 << 20));
+  }
+  state.SetItemsProcessed(state.iterations());
+  ReportHeapCalls(state, heap_calls - start);
+}
+
+// BM_DuplicateChurn - the same with state.range(0) values spread over
+//                     only kDuplicateKeys keys at a time
+template <typename Q>
+static void BM_DuplicateChurn(benchmark::State &state) {
+  std::vector<QueueKey> keys = randomKeys(state.range(0), 3);
+  for (auto &key : keys)
+    key %= kDuplicateKeys;
+  std::unique_ptr<Q> queue(fill<Q>(keys));
+  uint32_t seed = 42;
+  uint64_t start = heap_calls;
+  for (auto _ : state) {
+    QueueKey key = queue->PopMin();
+    queue->Insert(key + 1 + NextKey(seed) % kDuplicateKeys);
+  }
+  state.SetItemsProcessed(state.iterations());
+  ReportHeapCalls(state, heap_calls - start);
+}
+
+// Trees built by BM_BulkLoad & BM_InsertSorted
+typedef Multimap<int, int, PoolAllocator> PooledMultimap;
+typedef Map<int, int, PoolAllocator> PooledMap;
+
+// sortedPairs - @n (key, value) pairs with ascending keys
+static std::vector<std::pair<int, int>> sortedPairs(int64_t n) {
+  std::vector<std::pair<int, int>> pairs(n);
+  for (std::size_t i = 0; i < pairs.size(); i++)
+    pairs[i] = std::make_pair(static_cast<int>(i), 0);
+  return pairs;
+}
+
+// BM_BulkLoad - build & free a tree of state.range(0) sorted pairs in
+//               one linear-time BulkLoad
+template <typename T>
+static void BM_BulkLoad(benchmark::State &state) {
+  std::vector<std::pair<int, int>> pairs = sortedPairs(state.range(0));
+  for (auto _ : state)
+    delete new T(pairs.begin(), pairs.end());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_InsertSorted - the same tree built by one Insert per pair
+template <typename T>
+static void BM_InsertSorted(benchmark::State &state) {
+  std::vector<std::pair<int, int>> pairs = sortedPairs(state.range(0));
+  for (auto _ : state) {
+    T *tree = new T;
+    for (auto &kv : pairs)
+      tree->Insert(kv.first, kv.second);
+    delete tree;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_Move - renice pattern on state.range(0) values: take a random
+//           value out from under its key & reinsert it under a new key,
+//           with about 4 values per key
+template <typename Q>
+static void BM_Move(benchmark::State &state) {
+  const int64_t n = state.range(0);
+  const QueueKey key_range = n / 4 + 1;
+  std::vector<QueueKey> keys = randomKeys(n, 6);
+  Q queue;
+  for (int64_t i = 0; i < n; i++) {
+    keys[i] %= key_range;
+    queue.Insert(keys[i], static_cast<int>(i));
+  }
+  uint32_t seed = 13;
+  for (auto _ : state) {
+    int value = static_cast<int>(NextKey(seed) % n);
+    QueueKey new_key = NextKey(seed) % key_range;
+    queue.Move(keys[value], value, new_key);
+    keys[value] = new_key;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// BM_Contains - Contains() on state.range(0) random keys, alternating
+//               hits & (almost always) misses
+template <typename Q>
+static void BM_Contains(benchmark::State &state) {
+  std::vector<QueueKey> keys = randomKeys(state.range(0), 4);
+  std::unique_ptr<Q> queue(fill<Q>(keys));
+  uint32_t seed = 9;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queue->Contains(keys[i]));
+    benchmark::DoNotOptimize(queue->Contains(NextKey(seed)));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// BM_Get - Get() of present keys in random order from state.range(0)
+//          random keys
+template <typename Q>
+static void BM_Get(benchmark::State &state) {
+  std::vector<QueueKey> keys = randomKeys(state.range(0), 5);
+  std::unique_ptr<Q> queue(fill<Q>(keys));
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(5));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queue->Get(keys[i]));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// BM_Min - latency of Min() on state.range(0) random keys
+template <typename Q>
+static void BM_Min(benchmark::State &state) {
+  std::unique_ptr<Q> queue(fill<Q>(randomKeys(state.range(0), 3)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(queue->Min());
+}
+
+// BM_Max - latency of Max() on state.range(0) random keys
+template <typename Q>
+static void BM_Max(benchmark::State &state) {
+  std::unique_ptr<Q> queue(fill<Q>(randomKeys(state.range(0), 3)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(queue->Max());
+}
+
+// BM_MapMin - latency of Min() on a map of state.range(0) keys
+static void BM_MapMin(benchmark::State &state) {
+  Map<int, int, PoolAllocator> map;
+  for (int64_t i = 0; i < state.range(0); i++)
+    map.Insert(static_cast<int>(i), 0);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(map.Min());
+}
+
+BENCHMARK_TEMPLATE(BM_MultimapChurn, HeapAllocator)
+  ->RangeMultiplier(10)->Range(1000, 10000000);
+BENCHMARK_TEMPLATE(BM_MultimapChurn, PoolAllocator)
+  ->RangeMultiplier(10)->Range(1000, 10000000);
+BENCHMARK_TEMPLATE(BM_MapChurn, HeapAllocator)
+  ->RangeMultiplier(10)->Range(1000, 10000000);
+BENCHMARK_TEMPLATE(BM_MapChurn, PoolAllocator)
+  ->RangeMultiplier(10)->Range(1000, 10000000);
+
+BENCHMARK(BM_MultimapRemove)->RangeMultiplier(10)->Range(1000, 1000000)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MapMin)->RangeMultiplier(10)->Range(100, 10000000);
+BENCHMARK(BM_TimelineFootprint)->Arg(1000000)->Iterations(1)
+  ->Unit(benchmark::kMillisecond);
+
+// Sizes - run a benchmark at 1e2 to 1e7 keys
+static void Sizes(benchmark::internal::Benchmark *b) {
+  b->RangeMultiplier(10)->Range(100, 10000000);
+}
+
+BENCHMARK_TEMPLATE(BM_InsertRandom, TreeQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_InsertRandom, StdMultimapQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_InsertRandom, HeapQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_InsertSequential, TreeQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_InsertSequential, StdMultimapQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_InsertSequential, HeapQueue)->Apply(Sizes)
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_PopMinChurn, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_PopMinChurn, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_PopMinChurn, HeapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DuplicateChurn, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DuplicateChurn, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_DuplicateChurn, HeapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Move, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Move, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Contains, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Contains, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Get, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Get, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Min, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Min, StdMultimapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Min, HeapQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Max, TreeQueue)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_Max, StdMultimapQueue)->Apply(Sizes);
+
+BENCHMARK_TEMPLATE(BM_BulkLoad, PooledMultimap)->Arg(1000000)->Arg(10000000)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InsertSorted, PooledMultimap)->Arg(1000000)
+  ->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkLoad, PooledMap)->Arg(1000000)->Arg(10000000)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_InsertSorted, PooledMap)->Arg(1000000)->Arg(10000000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
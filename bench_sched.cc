@@ -0,0 +1,163 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// bench_sched.cc - Benchmarks for the scheduler's supporting pieces
+// Status sinks: status lines per second written to /dev/null, against
+// the original std::cout << ... << std::endl per tick
+// Loading: task lines per second through storeData's formatted stream
+// extraction & through the mapped loadTasks
+// Ticks: per-tick runtime accounting with nice weights, against the
+// original unweighted increments
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cfs_sched.h"
+#include "status_sink.h"
+
+// Ticks each task runs before the next takes over, so run-length
+// encoding has something to merge
+static const unsigned int kRunTicks = 4;
+
+// BM_SinkEndl - original per-tick formatting with a flush per line
+static void BM_SinkEndl(benchmark::State &state) {
+  std::ofstream out("/dev/null");
+  unsigned int tick = 0;
+  for (auto _ : state) {
+    out << tick << " [" << 3 << "]: " <<
+      static_cast<char>('A' + tick / kRunTicks % 26) << std::endl;
+    tick++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// BM_Sink - report one tick per iteration to @Sink
+template <typename Sink>
+static void BM_Sink(benchmark::State &state) {
+  std::ofstream out("/dev/null");
+  Sink sink(out);
+  unsigned int tick = 0;
+  for (auto _ : state) {
+    sink.Report(tick, tick, 3, static_cast<char>('A' + tick / kRunTicks % 26),
+                false);
+    tick++;
+  }
+  sink.Flush();
+  state.SetItemsProcessed(state.iterations());
+}
+
+// taskFile - path of a generated file with @lines task lines, written on
+//            first use
+static std::string taskFile(int64_t lines) {
+  std::string file_name = "/tmp/bench_tasks_" + std::to_string(lines) +
+    ".dat";
+  std::ifstream existing(file_name);
+  if (existing.is_open())
+    return file_name;
+
+  std::ofstream out(file_name);
+  uint32_t seed = 1;
+  for (int64_t i = 0; i < lines; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    out << static_cast<char>('A' + i % 26) << ' ' << (seed >> 12) << ' ' <<
+      1 + (seed & 0xfff) << '\n';
+  }
+  return file_name;
+}
+
+// BM_StoreData - load state.range(0) lines with std::ifstream extraction
+static void BM_StoreData(benchmark::State &state) {
+  std::string file_name = taskFile(state.range(0));
+  std::vector<Task> task_list;
+  for (auto _ : state) {
+    std::ifstream data_file(file_name);
+    storeData(task_list, data_file);
+    state.PauseTiming();
+    task_list.clear();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// BM_LoadTasks - load state.range(0) lines through the mapped scanner
+static void BM_LoadTasks(benchmark::State &state) {
+  std::string file_name = taskFile(state.range(0));
+  std::vector<Task> task_list;
+  for (auto _ : state) {
+    loadTasks(task_list, file_name.c_str());
+    state.PauseTiming();
+    task_list.clear();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// UnweightedTask - runtime accounting before nice levels
+class UnweightedTask {
+ public:
+    void incRunTimes(void) {
+      runtime++;
+      vruntime++;
+    }
+
+    unsigned int getvRuntime(void) const {
+      return vruntime;
+    }
+
+ private:
+    unsigned int runtime = 0;
+    unsigned int vruntime = 0;
+};
+
+// Tasks charged in turn, so the updates go through memory
+static const std::size_t kTickTasks = 64;
+
+// BM_TickUnweighted - charge one tick & read back vruntime, as the
+//                     scheduler does before its preemption check
+static void BM_TickUnweighted(benchmark::State &state) {
+  std::vector<UnweightedTask> tasks(kTickTasks);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    tasks[i].incRunTimes();
+    benchmark::DoNotOptimize(tasks[i].getvRuntime());
+    i = (i + 1) % kTickTasks;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// BM_TickWeighted - the same for pooled tasks at nice level
+//                   state.range(0)
+static void BM_TickWeighted(benchmark::State &state) {
+  TaskPool pool(kTickTasks);
+  std::vector<TaskHandle> tasks;
+  for (std::size_t i = 0; i < kTickTasks; i++)
+    tasks.push_back(pool.Admit('A', 1, static_cast<int>(state.range(0)), 0));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    pool.incRunTimes(tasks[i]);
+    benchmark::DoNotOptimize(pool.getvRuntime(tasks[i]));
+    i = (i + 1) % kTickTasks;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SinkEndl);
+BENCHMARK_TEMPLATE(BM_Sink, TextSink);
+BENCHMARK_TEMPLATE(BM_Sink, RunLengthSink);
+BENCHMARK(BM_StoreData)->RangeMultiplier(10)->Range(1000000, 100000000)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadTasks)->RangeMultiplier(10)->Range(1000000, 100000000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_TickUnweighted);
+BENCHMARK(BM_TickWeighted)->Arg(0)->Arg(-20)->Arg(19);
+
+BENCHMARK_MAIN();
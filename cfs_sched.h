@@ -0,0 +1,1018 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// cfs_sched.h - Implementation of the CFS Linux Kernel Scheduler.
+// Task & Scheduler classes along with the helpers that load, order
+// and run a list of tasks through the CFS scheduler strategy.
+// Tasks reach the scheduler through a TaskSource, either an ordered
+// task list or a stream of tasks admitted as they are read. A task may
+// sleep between CPU bursts; sleepers & the next task to arrive wait on
+// a timer wheel.
+// Built with -DCFS_TREE_STATS, the timeline counts its tree operations.
+//
+
+#ifndef CFS_SCHED_H_
+#define CFS_SCHED_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "latency_stats.h"
+#include "intrusive_tree.h"
+#include "nice_weights.h"
+#include "status_sink.h"
+#include "task_bursts.h"
+#include "task_groups.h"
+#include "task_loader.h"
+#include "task_pool.h"
+#include "timer_wheel.h"
+#include "tree_stats.h"
+#include "vruntime.h"
+
+// Task - class to represent a Task object as described in a task file;
+//        run state of admitted tasks is kept in a TaskPool
+class Task {
+ public:
+    // Task() - Task Constructor for initialization, @nice in
+    //          [kMinNice, kMaxNice], running in TaskGroups id @g, its
+    //          bursts & sleeps at TaskBursts offset @b
+    Task(char n, uint64_t ts, uint64_t d, int nice = 0,
+         uint32_t g = TaskGroups::kRoot, uint64_t b = TaskBursts::kNone) :
+    id(n), nice_level(static_cast<int8_t>(nice)), group(g), start_time(ts),
+    duration(d), bursts(b) {}
+
+    // Task() - Task Constructor from a parsed task line, its group path
+    //          interned as @g & its bursts as @b
+    explicit Task(const TaskRecord& rec, uint32_t g = TaskGroups::kRoot,
+                  uint64_t b = TaskBursts::kNone) :
+    Task(rec.id, rec.start_time, rec.duration, rec.nice, g, b) {}
+
+    // getID - return the task's id
+    char getID(void) const {
+      return id;
+    }
+
+    // getStartTime - return the task's start_time
+    uint64_t getStartTime(void) const {
+      return start_time;
+    }
+
+    // getDuration - return the task's duration
+    uint64_t getDuration(void) const {
+      return duration;
+    }
+
+    // getNice - return the task's nice level
+    int getNice(void) const {
+      return nice_level;
+    }
+
+    // getGroup - return id of the task's group
+    uint32_t getGroup(void) const {
+      return group;
+    }
+
+    // getBursts - return offset of the task's bursts & sleeps, kNone if
+    //             it never sleeps
+    uint64_t getBursts(void) const {
+      return bursts;
+    }
+
+    // operator<< - overload the operator<< to print out Task values
+    friend std::ostream& operator<<(std::ostream& os, const Task& t) {
+      os << t.id << " " << t.start_time << " " << t.duration <<
+        " nice:" << t.getNice() << std::endl;
+      return os;
+    }
+
+ private:
+    // Variables to id, nice level, group, tick starting point, duration
+    // & bursts
+    char id;
+    int8_t nice_level;
+    uint32_t group;
+    uint64_t start_time;
+    uint64_t duration;
+    uint64_t bursts;
+};
+
+// TaskSource - tasks in the order they are admitted to the scheduler
+class TaskSource {
+ public:
+    virtual ~TaskSource(void) = default;
+
+    // NextStart - store start time of the next task to arrive in @start;
+    //             return false once no tasks remain
+    virtual bool NextStart(uint64_t *start) = 0;
+
+    // Pop - remove & return the next task to arrive
+    virtual Task Pop(void) = 0;
+
+    // Groups - return names of the groups tasks run in, null if every
+    //          task runs in the root group
+    virtual const TaskGroups* Groups(void) const {
+      return nullptr;
+    }
+
+    // Bursts - return bursts & sleeps of the tasks, null if every task
+    //          runs its whole duration in one burst
+    virtual const TaskBursts* Bursts(void) const {
+      return nullptr;
+    }
+};
+
+// TaskListSource - tasks of a list already ordered by organizeTasks
+class TaskListSource : public TaskSource {
+ public:
+    // TaskListSource() - groups of @tasks are named in @groups & their
+    //                    bursts stored in @bursts, if any
+    explicit TaskListSource(const std::vector<Task>& tasks,
+                            const TaskGroups *groups = nullptr,
+                            const TaskBursts *bursts = nullptr) :
+        task_list(tasks), group_names(groups), burst_ticks(bursts),
+        next_arrival(0) {}
+
+    bool NextStart(uint64_t *start) override {
+      if (next_arrival == task_list.size())
+        return false;
+      *start = task_list[next_arrival].getStartTime();
+      return true;
+    }
+
+    Task Pop(void) override {
+      return task_list[next_arrival++];
+    }
+
+    const TaskGroups* Groups(void) const override {
+      return group_names;
+    }
+
+    const TaskBursts* Bursts(void) const override {
+      return burst_ticks;
+    }
+
+ private:
+    const std::vector<Task>& task_list;
+    const TaskGroups *group_names;
+    const TaskBursts *burst_ticks;
+    // Index of next task in task_list waiting to arrive
+    std::size_t next_arrival;
+};
+
+// TaskStream - tasks parsed from a descriptor as the scheduler reaches
+//              their start times; lines must arrive in nondecreasing
+//              start time order & tasks arriving together are ordered
+//              as organizeTasks would
+class TaskStream : public TaskSource {
+ public:
+    // TaskStream() - read from @fd, draining @sink whenever the writer
+    //                falls behind so output never waits on input
+    explicit TaskStream(int fd, StatusSink *sink = nullptr) :
+        scanner(fd, [sink] {
+          if (sink)
+            sink->Drain();
+        }) {}
+
+    TaskStream(const TaskStream&) = delete;
+    TaskStream& operator=(const TaskStream&) = delete;
+
+    bool NextStart(uint64_t *start) override {
+      if (next < batch.size()) {
+        *start = batch[next].getStartTime();
+        return true;
+      }
+      if (!pending && !ReadPending())
+        return false;
+      *start = rec.start_time;
+      return true;
+    }
+
+    Task Pop(void) override {
+      if (next == batch.size())
+        ReadBatch();
+      return batch[next++];
+    }
+
+    const TaskGroups* Groups(void) const override {
+      return &groups;
+    }
+
+    const TaskBursts* Bursts(void) const override {
+      return &bursts;
+    }
+
+ private:
+    StreamScanner scanner;
+    // Group paths named so far
+    TaskGroups groups;
+    // Bursts & sleeps read so far, kept for the whole run
+    TaskBursts bursts;
+    // Tasks sharing the current start time, sorted by id
+    std::vector<Task> batch;
+    std::size_t next = 0;
+    // First record of the following start time, read ahead, its group
+    // & its bursts
+    TaskRecord rec;
+    uint32_t rec_group = TaskGroups::kRoot;
+    uint64_t rec_bursts = TaskBursts::kNone;
+    bool pending = false;
+    uint64_t last_start = 0;
+
+    // ReadPending - read ahead the next record; return false at end
+    //               of input, throw if it starts before the last one
+    bool ReadPending(void) {
+      if (!scanner.Next(rec))
+        return false;
+      if (rec.start_time < last_start)
+        throw TaskParseError(scanner.getRecordLine(), 1,
+                             "start time out of order");
+      last_start = rec.start_time;
+      // Intern now, the text is only valid until the next read
+      rec_group = groups.Intern(rec.group, rec.group_length);
+      rec_bursts = rec.bursts ? bursts.Intern(rec.bursts, rec.bursts_length)
+                              : TaskBursts::kNone;
+      pending = true;
+      return true;
+    }
+
+    // ReadBatch - read every task starting with the pending record
+    void ReadBatch(void) {
+      batch.clear();
+      next = 0;
+      if (!pending)
+        ReadPending();
+      uint64_t start = rec.start_time;
+      // The batch ends at the first record with a later start time
+      do {
+        batch.push_back(Task(rec, rec_group, rec_bursts));
+        pending = false;
+      } while (ReadPending() && rec.start_time == start);
+      std::sort(batch.begin(), batch.end(), [](const Task& t1,
+                                                const Task& t2) {
+        return t1.getID() < t2.getID();
+      });
+    }
+};
+
+// Instrumentation policy of the timeline, counting only on request
+#ifdef CFS_TREE_STATS
+typedef CountingTreeStats TimelineStats;
+#else
+typedef NoTreeStats TimelineStats;
+#endif
+
+// PoolTimeline - orders the tasks of a pool by vruntime, surviving
+//                wrapping, through the links each slot holds
+class PoolTimeline {
+ public:
+    typedef TaskHandle Ref;
+
+    explicit PoolTimeline(TaskPool *tasks) : pool(tasks) {}
+
+    // Links - return timeline links of task @h
+    RbLinks<TaskHandle>& Links(TaskHandle h) {
+      return pool->getLinks(h);
+    }
+
+    // Less - return true if task @a is due before task @b
+    bool Less(TaskHandle a, TaskHandle b) {
+      return VRuntime(pool->getvRuntime(a)) < VRuntime(pool->getvRuntime(b));
+    }
+
+ private:
+    TaskPool *pool;
+};
+
+// PoolTimers - gives a timer wheel the links each slot of a pool holds
+class PoolTimers {
+ public:
+    typedef TaskHandle Ref;
+
+    explicit PoolTimers(TaskPool *tasks) : pool(tasks) {}
+
+    // Links - return timer wheel links of task @h
+    TimerLinks<TaskHandle>& Links(TaskHandle h) {
+      return pool->getTimerLinks(h);
+    }
+
+ private:
+    TaskPool *pool;
+};
+
+// TaskGroup - runqueue of a task group: its waiting tasks & child groups
+//             ordered by vruntime, & the one running on its behalf
+struct TaskGroup {
+  TaskGroup(TaskPool *pool, uint64_t initial_vruntime,
+            uint32_t parent_group = TaskGroups::kRoot) :
+      timeline(PoolTimeline(pool)), min_vruntime(initial_vruntime),
+      parent(parent_group) {}
+
+  // Waiting tasks & group entities, linked through the pool
+  IntrusiveTree<PoolTimeline, TimelineStats> timeline;
+  // vruntime of the leftmost entity when one was last picked
+  uint64_t min_vruntime;
+  // Running task or child group entity, null if none
+  TaskHandle curr;
+  // Entity of this group on its parent's timeline, null for the root
+  TaskHandle entity;
+  uint32_t parent;
+  // Runnable tasks in this group & every group below it, running or not
+  uint64_t tasks = 0;
+};
+
+// Scheduler - class to represent a CFL scheduler object
+class Scheduler {
+ public:
+    // Scheduler() - Scheduler Constructor for initialization;
+    //               tasks are admitted from @tasks, status is reported
+    //               to @out, min_vruntime starts at @initial_vruntime &
+    //               latency is recorded in @stats if not null
+    Scheduler(TaskSource& tasks, StatusSink& out,
+              uint64_t initial_vruntime = kInitialVRuntime,
+              LatencyStats *stats = nullptr) :
+        tick_counter(0), completed(0),
+        arrivals(tasks), root(&pool, initial_vruntime),
+        wheel(PoolTimers(&pool)), sink(out), latency(stats) {}
+
+    // ~Scheduler() - Scheduler Destructor
+    ~Scheduler(void) = default;
+
+    // appendTimeline - if tasks to be launched at tick value, add to timeline
+    void appendTimeline(void) {
+      // Sleepers waking & the task staged to arrive at tick value fire
+      // off the timer wheel first
+      wheel.Expire(tick_counter, [this](TaskHandle h) {
+        wakeTask(h);
+      });
+      // Tasks arrive by start time, so only those at the front of the
+      // source can be due; admit them in order, staging the first one
+      // still to come on the wheel
+      uint64_t start;
+      while (staged.isNull() && arrivals.NextStart(&start)) {
+        TaskHandle h = admitTask(arrivals.Pop());
+        if (start > tick_counter) {
+          staged = h;
+          wheel.Schedule(h, start);
+        } else {
+          enqueueTask(h, &queueOf(pool.getGroup(h)));
+        }
+      }
+    }
+
+    // moveNextTask - check if currently running task should transfer to next
+    void moveNextTask(void) {
+      // Walk down the running path; at the first group whose leftmost
+      // waiting entity is due before its running one, put the rest of
+      // the path back on the timelines
+      for (TaskGroup *g = &root; running();
+           g = &queueOf(pool.getGroup(g->curr))) {
+        if (g->timeline.Size() &&
+            vruntimeBefore(g->min_vruntime, pool.getvRuntime(g->curr))) {
+          putPrev(g);
+          return;
+        }
+        if (g->curr == current_task)
+          return;
+      }
+    }
+
+    // getNextTask - if current task stopped, get next schedulable task
+    void getNextTask(void) {
+      // If any task is waiting, walk down the leftmost entity of each
+      // group, keeping a group still running unless a waiting entity is
+      // due before it, until reaching a task
+      if (!running() && root.tasks) {
+        TaskGroup *g = &root;
+        for (;;) {
+          if (!g->curr.isNull() && g->timeline.Size() &&
+              vruntimeBefore(pool.getvRuntime(g->timeline.Front()),
+                             pool.getvRuntime(g->curr)))
+            putPrev(g);
+          if (g->curr.isNull()) {
+            // Pop min vruntime entity off the timeline, its links left
+            // in place
+            g->curr = g->timeline.PopMin();
+            // If not empty, set group's min_vruntime to next entity's
+            if (g->timeline.Size())
+              g->min_vruntime = pool.getvRuntime(g->timeline.Front());
+          }
+          if (!pool.isGroup(g->curr))
+            break;
+          g = &queueOf(pool.getGroup(g->curr));
+        }
+        current_task = pool.Check(g->curr);
+        running_group = g;
+        dispatches++;
+        // A task first dispatched has not run yet
+        if (latency && !pool.hasRun(current_task))
+          latency->recordDispatch(pool.getArrival(current_task),
+                                  tick_counter);
+      }
+    }
+
+    // incremenTask - current task runs for one tick
+    void incrementTask(void) {
+      // As long as current task is running, ++task's runtime & vruntime,
+      // & those of every group it runs in, at nice 0 weight
+      if (running()) {
+        pool.incRunTimes(current_task);
+        if (running_group != &root)
+          chargeGroups(1);
+      }
+    }
+
+    // printStatus - report current scheduling status to the sink
+    void printStatus(void) {
+      reportStatus(tick_counter, true);
+    }
+
+    // ticksUntilEvent - # of ticks from now, after steps 1-3, until the
+    //                   next arrival, wakeup, preemption, completion or
+    //                   sleep changes what the status line reports
+    uint64_t ticksUntilEvent(void) {
+      // 0 stands for no bound yet
+      uint64_t ticks = 0;
+      // Next wakeup or arrival, staged ahead of the rest, changes the #
+      // of running tasks
+      uint64_t next;
+      if (wheel.NextEvent(&next))
+        ticks = next - tick_counter;
+      if (running()) {
+        // Current task completes or goes to sleep
+        ticks = minTicks(ticks, pool.getBurstRemaining(current_task));
+        // Running path is preempted on the first tick the vruntime of
+        // an entity on it has passed its group's min_vruntime
+        for (TaskGroup *g = &root; ; g = &queueOf(pool.getGroup(g->curr))) {
+          if (g->timeline.Size())
+            ticks = minTicks(ticks, pool.ticksUntilPast(g->curr,
+                                                        g->min_vruntime));
+          if (g->curr == current_task)
+            break;
+        }
+      }
+      // Periodic latency report is due
+      if (latency)
+        ticks = minTicks(ticks, latency->ticksUntilReport(tick_counter));
+      // Nothing pending, report a single idle tick
+      return ticks ? ticks : 1;
+    }
+
+    // runStretch - perform steps 4-7 for @ticks ticks in bulk
+    void runStretch(uint64_t ticks) {
+      // 4) Current task & its groups run for all ticks
+      if (running()) {
+        pool.incRunTimes(current_task, ticks);
+        if (running_group != &root)
+          chargeGroups(ticks);
+      }
+      // 5) Report scheduling status for the whole stretch
+      reportStatus(tick_counter + ticks - 1, true);
+      // 6) If current task has completed, purge from system, or if its
+      //    burst is over, put it to sleep
+      purge(tick_counter + ticks - 1);
+      // 7) Jump to the tick after the stretch
+      tick_counter += ticks;
+      reportLatency();
+    }
+
+    // purgeCompletion - if current task has completed, purge from system
+    void purgeCompletion(void) {
+      purge(tick_counter);
+    }
+
+    // incrementTick - increment tick value by one so loop can restart
+    void incrementTick(void) {
+      tick_counter++;
+      reportLatency();
+    }
+
+    // done - return true if all tasks have arrived & completed
+    bool done(void) {
+      uint64_t start;
+      return !root.tasks && !wheel.Size() && !arrivals.NextStart(&start);
+    }
+
+    // findTask - return handle of a task with @id in the system, null if
+    //            none; a scan of the pool for callers knowing only the ID
+    TaskHandle findTask(char id) const {
+      return pool.Find(id);
+    }
+
+    // cancelTask - remove task @h from the system without completing it,
+    //              unlinking it from its group's timeline if it is
+    //              waiting, or from the timer wheel if it is sleeping or
+    //              staged to arrive; return false if @h is stale
+    bool cancelTask(TaskHandle h) {
+      if (!pool.Valid(h) || pool.isGroup(h))
+        return false;
+      if (wheel.Armed(h)) {
+        wheel.Cancel(h);
+        if (h == staged)
+          staged = TaskHandle();
+      } else {
+        dequeueTask(h, &queueOf(pool.getGroup(h)));
+      }
+      pool.Release(h);
+      cancelled++;
+      return true;
+    }
+
+    // reniceTask - move task @h to @nice; its lag behind its group's
+    //              min_vruntime is rescaled by old weight / new weight so
+    //              the CPU time it is owed stays the same, & a waiting
+    //              task is moved to its new place on the timeline; a task
+    //              on the timer wheel is placed anew when it wakes; return
+    //              false if @h is stale
+    bool reniceTask(TaskHandle h, int nice) {
+      if (nice < kMinNice || nice > kMaxNice)
+        throw std::out_of_range("nice level out of range");
+      if (!pool.Valid(h) || pool.isGroup(h))
+        return false;
+      if (wheel.Armed(h)) {
+        pool.setNice(h, nice);
+        return true;
+      }
+      TaskGroup& group = queueOf(pool.getGroup(h));
+      uint64_t v = pool.getvRuntime(h);
+      // Signed, the running task may be behind min_vruntime
+      int64_t lag = static_cast<int64_t>(v - group.min_vruntime);
+      lag = static_cast<int64_t>(static_cast<double>(lag) *
+                                 vruntimeStep(nice) /
+                                 vruntimeStep(pool.getNice(h)));
+      // Unlinked while its old vruntime still orders it
+      bool waiting = h != current_task;
+      if (waiting)
+        group.timeline.Remove(h);
+      pool.setNice(h, nice);
+      pool.setvRuntime(h, group.min_vruntime + static_cast<uint64_t>(lag));
+      if (waiting)
+        group.timeline.Insert(h);
+      return true;
+    }
+
+    // getTicks - return # of ticks simulated so far
+    uint64_t getTicks(void) const {
+      return tick_counter;
+    }
+
+    // getDispatches - return # of times a task was picked to run
+    uint64_t getDispatches(void) const {
+      return dispatches;
+    }
+
+    // getCompleted - return # of tasks completed
+    uint64_t getCompleted(void) const {
+      return completed;
+    }
+
+    // getCancelled - return # of tasks cancelled
+    uint64_t getCancelled(void) const {
+      return cancelled;
+    }
+
+    // setTopReport - list the @k leftmost waiting tasks after every
+    //                periodic latency report
+    void setTopReport(unsigned int k) {
+      top_report = k;
+    }
+
+    // printTimeline - write the running task & the @k waiting entities
+    //                 of the root group to be picked next, leftmost
+    //                 first, with each one's vruntime lag behind
+    //                 min_vruntime in nice 0 ticks; a group is listed by
+    //                 path with its # of runnable tasks
+    void printTimeline(std::ostream& os, unsigned int k) {
+      os << "timeline at tick " << tick_counter << ": running ";
+      if (running())
+        os << pool.getID(current_task);
+      else
+        os << '-';
+      os << " waiting " << root.timeline.Size() << '\n';
+      for (TaskHandle h = root.timeline.Front(); k && !h.isNull();
+           h = root.timeline.Next(h), k--) {
+        // Signed, a sleeper placed behind min_vruntime lags below 0
+        double lag = static_cast<double>(static_cast<int64_t>(
+            pool.getvRuntime(h) - root.min_vruntime)) / vruntimeStep(0);
+        if (pool.isGroup(h)) {
+          uint32_t g = pool.getGroup(h);
+          os << "  " << arrivals.Groups()->getPath(g) << " lag " << lag <<
+            " tasks " << queueOf(g).tasks << '\n';
+          continue;
+        }
+        os << "  " << pool.getID(h) << " lag " << lag << " remaining " <<
+          pool.getRemaining(h) << " nice " << pool.getNice(h) << '\n';
+      }
+      os.flush();
+    }
+
+    // getTreeStats - return operation counters of the root timeline
+    const TimelineStats& getTreeStats(void) {
+      return root.timeline.GetStats();
+    }
+
+ private:
+    // Tick counter
+    uint64_t tick_counter;
+    // Completed tasks counter
+    uint64_t completed;
+    // Tasks picked off the timeline to run
+    uint64_t dispatches = 0;
+    // Tasks removed before completing
+    uint64_t cancelled = 0;
+    // Tasks yet to arrive
+    TaskSource& arrivals;
+    // Run state of every task in the system
+    TaskPool pool;
+    // Runqueue of the root group, holding global min_vruntime & the
+    // intrusive RB-tree timeline of tasks & groups, linked through the
+    // pool so enqueuing & dequeuing never allocate
+    TaskGroup root;
+    // Runqueues of the other groups by TaskGroups id, made on first use
+    std::vector<std::unique_ptr<TaskGroup>> groups;
+    // Sleeping tasks & the next task to arrive, by the tick they wake on
+    TimerWheel<PoolTimers> wheel;
+    // Task admitted ahead of its start time, on the wheel, null if none
+    TaskHandle staged;
+    // Currently running task, null if none, & the group it runs in
+    TaskHandle current_task;
+    TaskGroup *running_group = nullptr;
+    // Destination of status reports
+    StatusSink& sink;
+    // Latency metrics, null if not recorded
+    LatencyStats *latency;
+    // # of waiting tasks listed after each periodic latency report
+    unsigned int top_report = 0;
+
+    // admitTask - store @task in the pool at its group's min_vruntime,
+    //             set to run its first burst; return its handle
+    TaskHandle admitTask(const Task& task) {
+      TaskGroup& group = groupQueue(task.getGroup());
+      TaskHandle h = pool.Admit(task.getID(), task.getDuration(),
+                                task.getNice(), group.min_vruntime,
+                                task.getStartTime(), task.getGroup());
+      uint64_t b = task.getBursts();
+      if (b != TaskBursts::kNone)
+        pool.nextBurst(h, burstTicks().getTicks(b), b + 1);
+      return h;
+    }
+
+    // burstTicks - return bursts & sleeps of the tasks of the source
+    const TaskBursts& burstTicks(void) {
+      const TaskBursts *bursts = arrivals.Bursts();
+      if (!bursts)
+        throw std::logic_error("task bursts unknown to its source");
+      return *bursts;
+    }
+
+    // wakeTask - put task @h, due on the timer wheel, on its group's
+    //            timeline: the staged arrival at min_vruntime, & a
+    //            sleeper at its own vruntime but no earlier than
+    //            kSleeperCredit before min_vruntime, brought up to date
+    //            first so the time it slept is not owed back to it
+    void wakeTask(TaskHandle h) {
+      TaskGroup& group = queueOf(pool.getGroup(h));
+      if (h == staged) {
+        staged = TaskHandle();
+        pool.setvRuntime(h, group.min_vruntime);
+      } else {
+        for (TaskGroup *g = &group; ; g = &queueOf(g->parent)) {
+          updateMin(g);
+          if (g == &root)
+            break;
+        }
+        uint64_t floor = group.min_vruntime - kSleeperCredit;
+        if (vruntimeBefore(pool.getvRuntime(h), floor))
+          pool.setvRuntime(h, floor);
+      }
+      enqueueTask(h, &group);
+    }
+
+    // updateMin - advance min_vruntime of @g, never backward, to the
+    //             earlier vruntime of its running & leftmost waiting
+    //             entities, as the kernel's update_min_vruntime does
+    void updateMin(TaskGroup *g) {
+      uint64_t v;
+      if (!g->curr.isNull())
+        v = pool.getvRuntime(g->curr);
+      else if (g->timeline.Size())
+        v = pool.getvRuntime(g->timeline.Front());
+      else
+        return;
+      if (g->timeline.Size() &&
+          vruntimeBefore(pool.getvRuntime(g->timeline.Front()), v))
+        v = pool.getvRuntime(g->timeline.Front());
+      if (vruntimeBefore(g->min_vruntime, v))
+        g->min_vruntime = v;
+    }
+
+    // sleepTask - take the current task, ending a burst on tick @last,
+    //             off its groups & onto the timer wheel until the tick
+    //             after its sleep, set to run its next burst
+    void sleepTask(uint64_t last) {
+      TaskHandle h = current_task;
+      const TaskBursts& bursts = burstTicks();
+      uint64_t phase = pool.getPhase(h);
+      uint64_t sleep = bursts.getTicks(phase);
+      dequeueTask(h, running_group);
+      pool.nextBurst(h, bursts.getTicks(phase + 1), phase + 2);
+      pool.addSlept(h, sleep);
+      wheel.Schedule(h, last + 1 + sleep);
+    }
+
+    // queueOf - return runqueue of existing group @g
+    TaskGroup& queueOf(uint32_t g) {
+      return g == TaskGroups::kRoot ? root : *groups[g];
+    }
+
+    // groupQueue - return runqueue of group @g, making it & any missing
+    //              ancestor with its entity at the parent's min_vruntime
+    TaskGroup& groupQueue(uint32_t g) {
+      if (g == TaskGroups::kRoot || (g < groups.size() && groups[g]))
+        return queueOf(g);
+      const TaskGroups *names = arrivals.Groups();
+      if (!names)
+        throw std::logic_error("task group unknown to its source");
+      uint32_t parent = names->getParent(g);
+      TaskGroup& prt = groupQueue(parent);
+      if (groups.size() <= g)
+        groups.resize(g + 1);
+      groups[g].reset(new TaskGroup(&pool, prt.min_vruntime, parent));
+      groups[g]->entity = pool.Admit(TaskPool::kNoID, 0, 0, prt.min_vruntime,
+                                     0, g);
+      return *groups[g];
+    }
+
+    // enqueueTask - put task @h on the timeline of its group @g, &
+    //               every group that had no tasks on its parent's, no
+    //               earlier than the parent's min_vruntime
+    void enqueueTask(TaskHandle h, TaskGroup *g) {
+      g->timeline.Insert(h);
+      // Count the task in @g & each ancestor below the root, waking
+      // groups until one already had tasks
+      bool waking = true;
+      for (; g != &root; g = &queueOf(g->parent)) {
+        if (waking && g->tasks == 0) {
+          TaskGroup& prt = queueOf(g->parent);
+          if (vruntimeBefore(pool.getvRuntime(g->entity), prt.min_vruntime))
+            pool.setvRuntime(g->entity, prt.min_vruntime);
+          prt.timeline.Insert(g->entity);
+        } else {
+          waking = false;
+        }
+        g->tasks++;
+      }
+      root.tasks++;
+    }
+
+    // dequeueTask - take task @h, running or waiting, off its group @g,
+    //               & every group left with no tasks off its parent
+    void dequeueTask(TaskHandle h, TaskGroup *g) {
+      TaskHandle e = h;
+      // Whether @e leaves @g
+      bool leaving = true;
+      for (;;) {
+        if (leaving) {
+          if (g->curr == e)
+            g->curr = TaskHandle();
+          else
+            g->timeline.Remove(e);
+        }
+        leaving = --g->tasks == 0;
+        if (g == &root)
+          break;
+        e = g->entity;
+        g = &queueOf(g->parent);
+      }
+      if (h == current_task)
+        current_task = TaskHandle();
+    }
+
+    // chargeGroups - advance runtime & vruntime of every group the current
+    //                task runs in by @ticks, at nice 0 weight
+    void chargeGroups(uint64_t ticks) {
+      for (TaskGroup *g = running_group; g != &root; g = &queueOf(g->parent))
+        pool.incRunTimes(g->entity, ticks);
+    }
+
+    // putPrev - put the running entity of @g & of each group below it on
+    //           the running path back on their timelines, down to the
+    //           current task or to a group whose task has stopped
+    void putPrev(TaskGroup *g) {
+      for (;;) {
+        TaskHandle c = g->curr;
+        g->curr = TaskHandle();
+        g->timeline.Insert(c);
+        if (!pool.isGroup(c))
+          break;
+        g = &queueOf(pool.getGroup(c));
+        if (g->curr.isNull())
+          break;
+      }
+      current_task = TaskHandle();
+    }
+
+    // running - return true if a task is currently running
+    bool running(void) const {
+      return !current_task.isNull();
+    }
+
+    // reportLatency - print a due periodic latency report, followed by
+    //                the leftmost waiting tasks if requested
+    void reportLatency(void) {
+      if (latency && latency->Tick(tick_counter) && top_report)
+        printTimeline(latency->getStream(), top_report);
+    }
+
+    // minTicks - return smaller of @ticks & @bound, 0 meaning unbounded
+    static uint64_t minTicks(uint64_t ticks, uint64_t bound) {
+      return (ticks == 0 || bound < ticks) ? bound : ticks;
+    }
+
+    // purge - if current task completed on tick @last, purge it from the
+    //         system, or if it ended a burst, put it to sleep
+    void purge(uint64_t last) {
+      // As long as current task is running & its burst is over -> remove
+      // if it is complete, else it sleeps
+      if (!running() || !pool.burstDone(current_task))
+        return;
+      if (!pool.isComplete(current_task)) {
+        sleepTask(last);
+        return;
+      }
+      // Increment compeleted tasks counter
+      completed++;
+      if (latency)
+        latency->recordCompletion(pool.getArrival(current_task), last,
+                                  pool.getDuration(current_task),
+                                  pool.getNice(current_task),
+                                  pool.getSlept(current_task));
+      // Take the task off its groups, set current task null & recycle
+      // its slot
+      TaskHandle h = current_task;
+      dequeueTask(h, running_group);
+      pool.Release(h);
+    }
+
+    // reportStatus - report ticks tick_counter..@last to the sink,
+    //                with '_' for no task & completion of current task
+    void reportStatus(uint64_t last, bool final) {
+      if (running())
+        sink.Report(tick_counter, last, runningTasks(),
+                    pool.getID(current_task),
+                    final && pool.isComplete(current_task));
+      else
+        sink.Report(tick_counter, last, runningTasks(), '_', false);
+    }
+
+    // runningTasks - return total # of running tasks, the current one
+    //                & those waiting in any group
+    unsigned int runningTasks(void) {
+      return static_cast<unsigned int>(root.tasks);
+    }
+};
+
+// storeData - store Data objects into vector
+inline void storeData(std::vector<Task>& task_list,
+                      std::ifstream& in_file) {
+  // Variables to temporarily store a Task id, start time, duration, nice
+  char id;
+  uint64_t start_time;
+  uint64_t duration;
+  int nice;
+  std::string line;
+
+  // Store each line's id, start time, duration & optional nice level
+  // into Task object, stopping at the first malformed line
+  while (std::getline(in_file, line)) {
+    std::istringstream fields(line);
+    if (!(fields >> id))
+      continue;
+    if (!(fields >> start_time >> duration))
+      break;
+    if (!(fields >> nice) || nice < kMinNice || nice > kMaxNice)
+      nice = 0;
+    task_list.push_back(Task(id, start_time, duration, nice));
+  }
+
+  in_file.close();
+}
+
+// loadTasks - map @file_name & parse its task lines straight into the
+//             Task list, interning group paths into @groups & bursts
+//             into @bursts if not null & else ignoring them, tasks then
+//             running their bursts back to back; throws TaskParseError
+//             on a malformed line
+inline void loadTasks(std::vector<Task>& task_list, const char *file_name,
+                      TaskGroups *groups = nullptr,
+                      TaskBursts *bursts = nullptr) {
+  MappedFile file(file_name);
+  TaskScanner scanner(file.begin(), file.end());
+  TaskRecord rec;
+
+  // One allocation for every task, sized by a fast newline count
+  task_list.reserve(task_list.size() + countLines(file.begin(), file.end()));
+  while (scanner.Next(rec))
+    task_list.push_back(Task(rec, groups ?
+                             groups->Intern(rec.group, rec.group_length) :
+                             TaskGroups::kRoot,
+                             bursts && rec.bursts ?
+                             bursts->Intern(rec.bursts, rec.bursts_length) :
+                             TaskBursts::kNone));
+}
+
+// alphaOrder - if tasks have equal start_time, order by id character
+inline bool alphaOrder(const Task& t1, const Task& t2) {
+  if (t1.getStartTime() == t2.getStartTime())
+    return t1.getID() < t2.getID();
+  // Otherwise, order by start time
+  return t1.getStartTime() < t2.getStartTime();
+}
+
+// organizeTasks - rearrange tasks so tasks with the same
+//                 start time run in alphabetical order ID
+inline void organizeTasks(std::vector<Task>& task_list) {
+  std::sort(task_list.begin(), task_list.end(), alphaOrder);
+}
+
+// RunStats - totals of a completed run
+struct RunStats {
+  uint64_t ticks = 0;
+  uint64_t dispatches = 0;
+  uint64_t completed = 0;
+  // Timeline operation counters, empty unless built with CFS_TREE_STATS
+  TimelineStats tree;
+};
+
+// runCFS - run the CFS algorithm using an intrusive RB-Tree on tasks from
+//          @tasks, reporting status to @sink; with @fast_forward the clock
+//          jumps from event to event; latency is recorded in @latency,
+//          if not null, & printed at the end, each periodic report
+//          followed by the @top leftmost waiting tasks; return the run's
+//          totals
+inline RunStats runCFS(TaskSource& tasks, StatusSink& sink,
+                       bool fast_forward = false,
+                       LatencyStats *latency = nullptr,
+                       unsigned int top = 0) {
+  // Scheduler object to handle timeline of tasks
+  Scheduler cfs(tasks, sink, kInitialVRuntime, latency);
+  cfs.setTopReport(top);
+
+  // CFS Algorithm
+  do {
+    // 1) If tasks to be launched at tick value, add to timeline
+    cfs.appendTimeline();
+    // 2) Check if currently running task should transfer to next task
+    cfs.moveNextTask();
+    // 3) If current task stopped running, get next task
+    cfs.getNextTask();
+    // 4-7) Run every tick until the next event in one go
+    if (fast_forward) {
+      cfs.runStretch(cfs.ticksUntilEvent());
+      continue;
+    }
+    // 4) Current task runs for one tick
+    cfs.incrementTask();
+    // 5) Report scheduling status
+    cfs.printStatus();
+    // 6) If current task has completed, purge from system
+    cfs.purgeCompletion();
+    // 7) Increment tick value by one, loop restarts
+    cfs.incrementTick();
+  // Keep running until all tasks are completed
+  } while (!cfs.done());
+
+  sink.Flush();
+  if (latency)
+    latency->Finish(cfs.getTicks());
+  RunStats stats;
+  stats.ticks = cfs.getTicks();
+  stats.dispatches = cfs.getDispatches();
+  stats.completed = cfs.getCompleted();
+  stats.tree = cfs.getTreeStats();
+  return stats;
+}
+
+// runCFS - run the CFS algorithm on a list ordered by organizeTasks
+inline RunStats runCFS(std::vector<Task>& task_list, StatusSink& sink,
+                       bool fast_forward = false,
+                       LatencyStats *latency = nullptr,
+                       unsigned int top = 0) {
+  TaskListSource tasks(task_list);
+  return runCFS(tasks, sink, fast_forward, latency, top);
+}
+
+// runCFS - run the CFS algorithm printing one status line per tick
+inline void runCFS(std::vector<Task>& task_list, bool fast_forward = false) {
+  TextSink sink(std::cout);
+  runCFS(task_list, sink, fast_forward);
+}
+
+#endif  // CFS_SCHED_H_
@@ -0,0 +1,96 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// gen_tasks.cc - Writes a synthetic task file for the CFS scheduler.
+// Start times come from Poisson, bursty or batched arrivals & durations
+// from a uniform, heavy-tailed or bimodal distribution, all drawn from
+// one seed. Lines are written in start-time order, so the output can be
+// piped straight into cfs_sched --stream.
+//
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "workload_gen.h"
+
+// Most tasks a file may hold
+static const uint64_t kMaxTasks = 100000000;
+
+// usage - print command-line usage & exit
+void usage(char *prog) {
+  std::cerr << "Usage: " << prog << " [--tasks <N>] [--seed <S>]"
+    " [--arrivals poisson|bursty|batch] [--rate <R>] [--burst <B>]"
+    " [--durations uniform|heavy-tail|bimodal] [--mean <D>] [--max <D>]"
+    " [--nice] [-o <task_file.dat>]" << std::endl;
+  exit(1);
+}
+
+// parseUInt - return @arg as a count in [@min, @max], else print usage
+uint64_t parseUInt(char *prog, const char *arg, uint64_t min, uint64_t max) {
+  char *end;
+  unsigned long long n = std::strtoull(arg, &end, 10);
+  if (*end || *arg == '-' || n < min || n > max)
+    usage(prog);
+  return n;
+}
+
+// Main method
+int main(int argc, char *argv[]) {
+  WorkloadSpec spec;
+  char *out_name = nullptr;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg(argv[i]);
+      if (arg == "--nice") {
+        spec.nice = true;
+        continue;
+      }
+      if (i + 1 == argc)
+        usage(argv[0]);
+      char *value = argv[++i];
+      if (arg == "--tasks") {
+        spec.tasks = parseUInt(argv[0], value, 0, kMaxTasks);
+      } else if (arg == "--seed") {
+        spec.seed = parseUInt(argv[0], value, 0, UINT64_MAX);
+      } else if (arg == "--arrivals") {
+        spec.arrivals = parseArrivals(value);
+      } else if (arg == "--rate") {
+        char *end;
+        spec.rate = std::strtod(value, &end);
+        if (*end || !(spec.rate > 0))
+          usage(argv[0]);
+      } else if (arg == "--burst") {
+        spec.burst = parseUInt(argv[0], value, 1, kMaxTasks);
+      } else if (arg == "--durations") {
+        spec.durations = parseDurations(value);
+      } else if (arg == "--mean") {
+        spec.mean_duration = parseUInt(argv[0], value, 1, UINT32_MAX);
+      } else if (arg == "--max") {
+        spec.max_duration = parseUInt(argv[0], value, 1, UINT64_MAX);
+      } else if (arg == "-o") {
+        out_name = value;
+      } else {
+        usage(argv[0]);
+      }
+    }
+  } catch (const std::invalid_argument&) {
+    usage(argv[0]);
+  }
+
+  if (!out_name) {
+    writeWorkload(spec, std::cout);
+    return 0;
+  }
+  std::ofstream out(out_name);
+  if (!out.is_open()) {
+    std::cerr << "Error: cannot write " << out_name << std::endl;
+    return 1;
+  }
+  writeWorkload(spec, out);
+  return out ? 0 : 1;
+}
@@ -0,0 +1,474 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// intrusive_tree.h - RB Tree whose link fields live inside the objects it
+// orders, so linking & unlinking never allocate & an object known to the
+// caller is removed without a key search. Same iterative algorithms as
+// multimap.h; as there, equal keys share one tree position: the first
+// object with a key sits in the tree & later ones queue behind it in
+// insertion order on a ring, taking its place when it leaves.
+// Public API: Size, Front, Next, Insert, Remove, PopMin, Clear, GetStats
+// Self-Balancing Helpers: IsRed, RotateRight, RotateLeft, Transplant,
+//                         InsertFixUp, EraseFixUp
+//
+
+#ifndef INTRUSIVE_TREE_H_
+#define INTRUSIVE_TREE_H_
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "tree_stats.h"
+
+// RbLinks - links an object embeds to sit in an IntrusiveTree; @Ref is
+//           how objects refer to each other, null when value-initialized
+template <typename Ref>
+struct RbLinks {
+  // Tree links, used by the first object of each key only
+  Ref left;
+  Ref right;
+  Ref parent;
+  // Ring of the objects with this key, in insertion order
+  Ref next;
+  Ref prev;
+  // Red or black in the tree, or chained behind the first object
+  uint8_t color;
+};
+
+// @Traits gives the tree access to the objects:
+//   typedef Ref - reference to an object, e.g. a pointer or index
+//   RbLinks<Ref>& Links(Ref n) - links embedded in @n
+//   bool Less(Ref a, Ref b) - key order of @a & @b
+// @Stats is the instrumentation policy (see tree_stats.h)
+template <typename Traits, typename Stats = NoTreeStats>
+class IntrusiveTree {
+ public:
+  typedef typename Traits::Ref Ref;
+
+  explicit IntrusiveTree(Traits t = Traits()) : traits(t) {}
+  IntrusiveTree(const IntrusiveTree&) = delete;
+  IntrusiveTree& operator=(const IntrusiveTree&) = delete;
+
+  // Return # of objects in tree
+  unsigned int Size();
+  // Return first object in key order, null if empty
+  Ref Front();
+  // Return object after @n in key order, null if last
+  Ref Next(Ref n);
+  // Link @n in behind every object with an equal key
+  void Insert(Ref n);
+  // Unlink @n, which must be in tree
+  void Remove(Ref n);
+  // Unlink & return first object in key order
+  Ref PopMin();
+  // Unlink all objects at once, leaving their links stale
+  void Clear();
+  // Return counters kept by the Stats policy since construction
+  const Stats& GetStats();
+
+ private:
+  enum Color { RED, BLACK, CHAINED };
+
+  Traits traits;
+  Ref root = Ref();
+  // Cached min object, maintained by Insert & Remove
+  Ref leftmost = Ref();
+  unsigned int cur_size = 0;
+  Stats stats;
+
+  // Links - return links of @n
+  RbLinks<Ref>& Links(Ref n) {
+    return traits.Links(n);
+  }
+
+  // IsNull - return true for the null reference
+  static bool IsNull(Ref n) {
+    return n == Ref();
+  }
+
+  // Helper methods for the self-balancing
+  bool IsRed(Ref n);
+  Ref TreeNext(Ref n);
+  void RotateRight(Ref x);
+  void RotateLeft(Ref x);
+  void Transplant(Ref u, Ref v);
+  void InsertFixUp(Ref z);
+  void EraseFixUp(Ref x, Ref x_prt);
+};
+
+// Size - return current size of tree
+template <typename Traits, typename Stats>
+unsigned int IntrusiveTree<Traits, Stats>::Size(void) {
+  return cur_size;
+}
+
+// Front - return cached min object
+template <typename Traits, typename Stats>
+typename IntrusiveTree<Traits, Stats>::Ref
+IntrusiveTree<Traits, Stats>::Front(void) {
+  return leftmost;
+}
+
+// Next - return in-order successor of @n (null if last): the next
+//        object with its key, else the first object of the next key
+template <typename Traits, typename Stats>
+typename IntrusiveTree<Traits, Stats>::Ref
+IntrusiveTree<Traits, Stats>::Next(Ref n) {
+  Ref nxt = Links(n).next;
+  // Ring wrapped around to the object in the tree -> key exhausted
+  if (Links(nxt).color == CHAINED)
+    return nxt;
+  return TreeNext(nxt);
+}
+
+// TreeNext - return in-order successor of tree object @n (null if last)
+template <typename Traits, typename Stats>
+typename IntrusiveTree<Traits, Stats>::Ref
+IntrusiveTree<Traits, Stats>::TreeNext(Ref n) {
+  // Successor is min of right subtree if there is one
+  if (!IsNull(Links(n).right)) {
+    n = Links(n).right;
+    while (!IsNull(Links(n).left)) {
+      stats.OnVisit();
+      n = Links(n).left;
+    }
+    return n;
+  }
+  // Otherwise climb until coming up from a left child
+  Ref prt = Links(n).parent;
+  while (!IsNull(prt) && n == Links(prt).right) {
+    n = prt;
+    prt = Links(prt).parent;
+  }
+  return prt;
+}
+
+// IsRed - check if object is red, null being black
+template <typename Traits, typename Stats>
+bool IntrusiveTree<Traits, Stats>::IsRed(Ref n) {
+  return !IsNull(n) && Links(n).color == RED;
+}
+
+// RotateRight - perform standard right rotation around @x
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::RotateRight(Ref x) {
+  Ref chd = Links(x).left;
+  Links(x).left = Links(chd).right;
+  if (!IsNull(Links(chd).right))
+    Links(Links(chd).right).parent = x;
+  Transplant(x, chd);
+  Links(chd).right = x;
+  Links(x).parent = chd;
+  stats.OnRotate();
+}
+
+// RotateLeft - perform standard left rotation around @x
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::RotateLeft(Ref x) {
+  Ref chd = Links(x).right;
+  Links(x).right = Links(chd).left;
+  if (!IsNull(Links(chd).left))
+    Links(Links(chd).left).parent = x;
+  Transplant(x, chd);
+  Links(chd).left = x;
+  Links(x).parent = chd;
+  stats.OnRotate();
+}
+
+// Transplant - hang @v (may be null) where @u hangs under its parent
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::Transplant(Ref u, Ref v) {
+  Ref prt = Links(u).parent;
+  if (IsNull(prt))
+    root = v;
+  else if (u == Links(prt).left)
+    Links(prt).left = v;
+  else
+    Links(prt).right = v;
+  if (!IsNull(v))
+    Links(v).parent = prt;
+}
+
+// InsertFixUp - climb from new red object @z resolving red-red
+//               violations: recolor when uncle is red, else rotate
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::InsertFixUp(Ref z) {
+  while (IsRed(Links(z).parent)) {
+    // A red parent is never the root, so grandparent exists
+    Ref prt = Links(z).parent;
+    Ref grand = Links(prt).parent;
+    // Parent on LEFT
+    if (prt == Links(grand).left) {
+      Ref uncle = Links(grand).right;
+      if (IsRed(uncle)) {
+        Links(prt).color = BLACK;
+        Links(uncle).color = BLACK;
+        Links(grand).color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        if (z == Links(prt).right) {
+          z = prt;
+          RotateLeft(z);
+          prt = Links(z).parent;
+        }
+        Links(prt).color = BLACK;
+        Links(grand).color = RED;
+        stats.OnRecolor(2);
+        RotateRight(grand);
+      }
+    // Parent on RIGHT, mirror image
+    } else {
+      Ref uncle = Links(grand).left;
+      if (IsRed(uncle)) {
+        Links(prt).color = BLACK;
+        Links(uncle).color = BLACK;
+        Links(grand).color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        if (z == Links(prt).left) {
+          z = prt;
+          RotateRight(z);
+          prt = Links(z).parent;
+        }
+        Links(prt).color = BLACK;
+        Links(grand).color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(grand);
+      }
+    }
+  }
+  Links(root).color = BLACK;
+}
+
+// EraseFixUp - climb from @x (may be null, hence @x_prt) which is short
+//              one black object, borrowing from or recoloring its sibling
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::EraseFixUp(Ref x, Ref x_prt) {
+  while (x != root && !IsRed(x)) {
+    // x on LEFT
+    if (x == Links(x_prt).left) {
+      Ref sib = Links(x_prt).right;
+      if (IsRed(sib)) {
+        Links(sib).color = BLACK;
+        Links(x_prt).color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(x_prt);
+        sib = Links(x_prt).right;
+      }
+      if (!IsRed(Links(sib).left) && !IsRed(Links(sib).right)) {
+        Links(sib).color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = Links(x).parent;
+      } else {
+        if (!IsRed(Links(sib).right)) {
+          Links(Links(sib).left).color = BLACK;
+          Links(sib).color = RED;
+          stats.OnRecolor(2);
+          RotateRight(sib);
+          sib = Links(x_prt).right;
+        }
+        Links(sib).color = Links(x_prt).color;
+        Links(x_prt).color = BLACK;
+        Links(Links(sib).right).color = BLACK;
+        stats.OnRecolor(3);
+        RotateLeft(x_prt);
+        x = root;
+      }
+    // x on RIGHT, mirror image
+    } else {
+      Ref sib = Links(x_prt).left;
+      if (IsRed(sib)) {
+        Links(sib).color = BLACK;
+        Links(x_prt).color = RED;
+        stats.OnRecolor(2);
+        RotateRight(x_prt);
+        sib = Links(x_prt).left;
+      }
+      if (!IsRed(Links(sib).left) && !IsRed(Links(sib).right)) {
+        Links(sib).color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = Links(x).parent;
+      } else {
+        if (!IsRed(Links(sib).left)) {
+          Links(Links(sib).right).color = BLACK;
+          Links(sib).color = RED;
+          stats.OnRecolor(2);
+          RotateLeft(sib);
+          sib = Links(x_prt).left;
+        }
+        Links(sib).color = Links(x_prt).color;
+        Links(x_prt).color = BLACK;
+        Links(Links(sib).left).color = BLACK;
+        stats.OnRecolor(3);
+        RotateRight(x_prt);
+        x = root;
+      }
+    }
+  }
+  if (IsRed(x)) {
+    Links(x).color = BLACK;
+    stats.OnRecolor(1);
+  }
+}
+
+// Insert - walk down past every equal key & attach @n as a red leaf, then
+//          rebalance upwards
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::Insert(Ref n) {
+  stats.OnInsert();
+  Ref prt = Ref();
+  Ref cur = root;
+  bool go_left = false;
+  bool is_min = true;
+  unsigned int depth = 0;
+  RbLinks<Ref> &links = Links(n);
+  while (!IsNull(cur)) {
+    stats.OnVisit();
+    depth++;
+    prt = cur;
+    // Go LEFT -> object is smaller
+    if (traits.Less(n, cur)) {
+      go_left = true;
+      cur = Links(cur).left;
+    // Go RIGHT -> object is greater
+    } else if (traits.Less(cur, n)) {
+      go_left = false;
+      cur = Links(cur).right;
+      is_min = false;
+    // Key already in tree, queue @n last on its ring
+    } else {
+      stats.OnDepth(depth);
+      Ref last = Links(cur).prev;
+      links.next = cur;
+      links.prev = last;
+      links.color = CHAINED;
+      Links(last).next = n;
+      Links(cur).prev = n;
+      cur_size++;
+      return;
+    }
+  }
+  // INSERT HERE -> new key, @n alone on its ring
+  stats.OnDepth(depth + 1);
+  links.left = Ref();
+  links.right = Ref();
+  links.parent = prt;
+  links.next = n;
+  links.prev = n;
+  links.color = RED;
+  if (IsNull(prt))
+    root = n;
+  else if (go_left)
+    Links(prt).left = n;
+  else
+    Links(prt).right = n;
+  if (is_min)
+    leftmost = n;
+  cur_size++;
+  InsertFixUp(n);
+}
+
+// Remove - unlink @z through its own links, no search needed; objects
+//          are relinked rather than copied so the others stay put
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::Remove(Ref z) {
+  stats.OnRemove();
+  Ref nxt = Links(z).next;
+  // Other objects share the key -> take @z off the ring
+  if (nxt != z) {
+    Ref prv = Links(z).prev;
+    Links(prv).next = nxt;
+    Links(nxt).prev = prv;
+    cur_size--;
+    if (Links(z).color == CHAINED)
+      return;
+    // @z was in the tree, the next object with its key takes its place
+    // & color, so no rebalancing is needed
+    RbLinks<Ref> &links = Links(nxt);
+    links.left = Links(z).left;
+    links.right = Links(z).right;
+    links.color = Links(z).color;
+    Transplant(z, nxt);
+    if (!IsNull(links.left))
+      Links(links.left).parent = nxt;
+    if (!IsNull(links.right))
+      Links(links.right).parent = nxt;
+    if (z == leftmost)
+      leftmost = nxt;
+    return;
+  }
+  if (z == leftmost)
+    leftmost = TreeNext(z);
+  // Color that leaves its position & object that moves into it
+  uint8_t removed_color = Links(z).color;
+  Ref x, x_prt;
+  // (1) At most one child, splice z out
+  if (IsNull(Links(z).left)) {
+    x = Links(z).right;
+    x_prt = Links(z).parent;
+    Transplant(z, x);
+  } else if (IsNull(Links(z).right)) {
+    x = Links(z).left;
+    x_prt = Links(z).parent;
+    Transplant(z, x);
+  // (2) Two children, successor y takes z's place & color
+  } else {
+    Ref y = Links(z).right;
+    while (!IsNull(Links(y).left)) {
+      stats.OnVisit();
+      y = Links(y).left;
+    }
+    removed_color = Links(y).color;
+    x = Links(y).right;
+    if (Links(y).parent == z) {
+      x_prt = y;
+    } else {
+      x_prt = Links(y).parent;
+      Transplant(y, x);
+      Links(y).right = Links(z).right;
+      Links(Links(y).right).parent = y;
+    }
+    Transplant(z, y);
+    Links(y).left = Links(z).left;
+    Links(Links(y).left).parent = y;
+    Links(y).color = Links(z).color;
+  }
+  cur_size--;
+  // Removing a black object shortens one path, restore black height
+  if (removed_color == BLACK)
+    EraseFixUp(x, x_prt);
+}
+
+// PopMin - unlink & return cached min object
+template <typename Traits, typename Stats>
+typename IntrusiveTree<Traits, Stats>::Ref
+IntrusiveTree<Traits, Stats>::PopMin(void) {
+  if (IsNull(root))
+    throw std::runtime_error("Error: cannot pop from empty tree");
+  Ref n = leftmost;
+  Remove(n);
+  return n;
+}
+
+// Clear - forget every object; the objects own their links, so nothing
+//         is freed
+template <typename Traits, typename Stats>
+void IntrusiveTree<Traits, Stats>::Clear(void) {
+  root = Ref();
+  leftmost = Ref();
+  cur_size = 0;
+}
+
+// GetStats - return counters kept by the Stats policy
+template <typename Traits, typename Stats>
+const Stats& IntrusiveTree<Traits, Stats>::GetStats(void) {
+  return stats;
+}
+
+#endif  // INTRUSIVE_TREE_H_
@@ -0,0 +1,217 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// latency_stats.h - Per-task latency metrics of a scheduler run.
+// LatencyHistogram: log-linear (HDR-style) histogram over all 64-bit
+//                   values in fixed memory, exact below 128 & within
+//                   1/64 of the value above
+// LatencyStats: response (arrival to first dispatch), wait & turnaround
+//               histograms plus Jain's fairness index of the CPU share
+//               each completed task got for its weight, printed at the
+//               end of a run or every N ticks
+//
+
+#ifndef LATENCY_STATS_H_
+#define LATENCY_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "nice_weights.h"
+
+// LatencyHistogram - counts of values in log-linear buckets
+class LatencyHistogram {
+ public:
+    // Bits of precision kept per value; every power of two range above
+    // kSubBuckets is split into kSubBuckets / 2 linear buckets
+    static const unsigned int kSubBucketBits = 7;
+    static const uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static const std::size_t kBuckets =
+      (64 - kSubBucketBits + 2) * (kSubBuckets / 2);
+
+    LatencyHistogram(void) : counts(kBuckets, 0) {}
+
+    // Record - count one occurrence of @value
+    void Record(uint64_t value) {
+      counts[Index(value)]++;
+      total++;
+      if (value > max)
+        max = value;
+    }
+
+    // Count - return # of values recorded
+    uint64_t Count(void) const {
+      return total;
+    }
+
+    // Max - return largest value recorded, exactly
+    uint64_t Max(void) const {
+      return max;
+    }
+
+    // Percentile - return the value at or below which @p percent of the
+    //              recorded values fall, as the top of its bucket
+    uint64_t Percentile(double p) const {
+      if (!total)
+        return 0;
+      // Rank of the value, at least the first
+      uint64_t rank = static_cast<uint64_t>(p / 100 * total + 0.5);
+      if (rank == 0)
+        rank = 1;
+      uint64_t seen = 0;
+      for (std::size_t i = 0; i < kBuckets; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+          return Highest(i) < max ? Highest(i) : max;
+      }
+      return max;
+    }
+
+    // Index - return bucket of @value
+    static std::size_t Index(uint64_t value) {
+      if (value < kSubBuckets)
+        return static_cast<std::size_t>(value);
+      // Magnitude: how far @value is shifted to fit in kSubBucketBits
+      unsigned int shift = 63 - __builtin_clzll(value) - kSubBucketBits + 1;
+      return static_cast<std::size_t>((shift + 1) * (kSubBuckets / 2) +
+                                      (value >> shift) - kSubBuckets / 2);
+    }
+
+    // Highest - return largest value counted in bucket @i
+    static uint64_t Highest(std::size_t i) {
+      if (i < kSubBuckets)
+        return i;
+      unsigned int shift = static_cast<unsigned int>(i / (kSubBuckets / 2)) -
+        1;
+      uint64_t top = i % (kSubBuckets / 2) + kSubBuckets / 2;
+      return ((top + 1) << shift) - 1;
+    }
+
+ private:
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max = 0;
+};
+
+// LatencyStats - latency & fairness of the tasks of one run
+class LatencyStats {
+ public:
+    // LatencyStats() - print reports to @out, every @every ticks if
+    //                  nonzero as well as at the end of the run
+    explicit LatencyStats(std::ostream& out = std::cerr,
+                          uint64_t every = 0) :
+        os(out), interval(every), next_report(every ? every : ~uint64_t(0)) {}
+
+    // recordDispatch - a task arriving at @arrival first ran on @tick
+    void recordDispatch(uint64_t arrival, uint64_t tick) {
+      response.Record(tick - arrival);
+    }
+
+    // recordCompletion - a task at @nice arriving at @arrival completed
+    //                    on @tick after running for @duration ticks &
+    //                    sleeping for @slept
+    void recordCompletion(uint64_t arrival, uint64_t tick, uint64_t duration,
+                          int nice, uint64_t slept = 0) {
+      uint64_t turnaround_ticks = tick + 1 - arrival;
+      turnaround.Record(turnaround_ticks);
+      wait.Record(turnaround_ticks - duration - slept);
+      // Share of the CPU while runnable, relative to the share its
+      // weight entitles it to against a nice 0 task
+      double share = static_cast<double>(duration) /
+        (turnaround_ticks - slept) * kNice0Load /
+        kPrioToWeight[nice - kMinNice];
+      share_sum += share;
+      share_squares += share * share;
+    }
+
+    // Jain - return Jain's fairness index of the weighted CPU shares of
+    //        the completed tasks: 1 when all are equal, down to 1 / n
+    double Jain(void) const {
+      if (!share_squares)
+        return 1;
+      return share_sum * share_sum / (turnaround.Count() * share_squares);
+    }
+
+    // ticksUntilReport - # of ticks from @tick until the next periodic
+    //                    report is due, 0 if there are none
+    uint64_t ticksUntilReport(uint64_t tick) const {
+      return interval ? interval - tick % interval : 0;
+    }
+
+    // Tick - print a periodic report if one is due once @tick ticks ran;
+    //        return true if it was printed
+    bool Tick(uint64_t tick) {
+      if (tick != next_report)
+        return false;
+      Print(tick);
+      next_report += interval;
+      return true;
+    }
+
+    // Finish - print the final report after @tick ticks, unless the
+    //          periodic report already covered it
+    void Finish(uint64_t tick) {
+      if (printed != tick)
+        Print(tick);
+    }
+
+    // Print - write out the metrics after @tick ticks
+    void Print(uint64_t tick) {
+      printed = tick;
+      os << "latency at tick " << tick << ": completed " <<
+        turnaround.Count() << '\n';
+      PrintHistogram("response", response);
+      PrintHistogram("wait", wait);
+      PrintHistogram("turnaround", turnaround);
+      os << "fairness: jain " << std::fixed << std::setprecision(4) <<
+        Jain() << std::defaultfloat << std::endl;
+    }
+
+    // getStream - return destination of the reports
+    std::ostream& getStream(void) {
+      return os;
+    }
+
+    // getResponse - return histogram of arrival to first dispatch
+    const LatencyHistogram& getResponse(void) const {
+      return response;
+    }
+
+    // getWait - return histogram of ticks runnable but not running
+    const LatencyHistogram& getWait(void) const {
+      return wait;
+    }
+
+    // getTurnaround - return histogram of arrival to completion
+    const LatencyHistogram& getTurnaround(void) const {
+      return turnaround;
+    }
+
+ private:
+    std::ostream& os;
+    uint64_t interval;
+    // Tick the next periodic report is due on, all ones if none
+    uint64_t next_report;
+    // Tick of the last report, all ones if none
+    uint64_t printed = ~uint64_t(0);
+    LatencyHistogram response;
+    LatencyHistogram wait;
+    LatencyHistogram turnaround;
+    // Running sums for Jain's index
+    double share_sum = 0;
+    double share_squares = 0;
+
+    // PrintHistogram - write "<name>: count .. p50 .. p90 .. p99 ..
+    //                  p99.9 .. max .." for @h
+    void PrintHistogram(const char *name, const LatencyHistogram& h) {
+      os << name << ": count " << h.Count() << " p50 " << h.Percentile(50) <<
+        " p90 " << h.Percentile(90) << " p99 " << h.Percentile(99) <<
+        " p99.9 " << h.Percentile(99.9) << " max " << h.Max() << '\n';
+    }
+};
+
+#endif  // LATENCY_STATS_H_
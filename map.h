@@ -1,14 +1,30 @@
 #ifndef MAP_H_
 #define MAP_H_
 
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 
-template <typename K, typename V>
+#include "node_allocator.h"
+#include "tree_stats.h"
+
+template <typename K, typename V,
+          template <typename> class Alloc = HeapAllocator,
+          typename Stats = NoTreeStats>
 class Map {
  public:
+  Map() = default;
+  // Build tree from (key, value) pairs in [@first, @last) sorted by key
+  template <typename Iter>
+  Map(Iter first, Iter last);
+  Map(const Map&) = delete;
+  Map& operator=(const Map&) = delete;
+  ~Map();
+
   // Return size of tree
   unsigned int Size();
   // Return value associated to @key
@@ -23,8 +39,16 @@ class Map {
   void Insert(const K &key, const V &value);
   // Remove @key from tree
   void Remove(const K &key);
+  // Replace contents with (key, value) pairs in [@first, @last) sorted by
+  // unique key, in linear time
+  template <typename Iter>
+  void BulkLoad(Iter first, Iter last);
+  // Remove all keys from tree
+  void Clear();
   // Print tree in-order
   void Print();
+  // Return counters kept by the Stats policy since construction
+  const Stats& GetStats();
 
  private:
   enum Color { RED, BLACK };
@@ -32,248 +56,484 @@ class Map {
     K key;
     V value;
     bool color;
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> right;
+    Node *left;
+    Node *right;
+    Node *parent;
   };
-  std::unique_ptr<Node> root;
+  Node *root = nullptr;
+  // Cached min node, only changed by node creation & deletion
+  Node *leftmost = nullptr;
   unsigned int cur_size = 0;
+  Stats stats;
+  Alloc<Node> alloc;
 
   // Iterative helper methods
   Node* Get(Node *n, const K &key);
-
-  // Recursive helper methods
   Node* Min(Node *n);
-  void Insert(std::unique_ptr<Node> &n, const K &key, const V &value);
-  void Remove(std::unique_ptr<Node> &n, const K &key);
-  void Print(Node *n);
+  Node* Next(Node *n);
+  void Erase(Node *z);
+  Node* Build(Node *chain, unsigned int count);
 
   // Helper methods for the self-balancing
   bool IsRed(Node *n);
-  void FlipColors(Node *n);
-  void RotateRight(std::unique_ptr<Node> &prt);
-  void RotateLeft(std::unique_ptr<Node> &prt);
-  void FixUp(std::unique_ptr<Node> &n);
-  void MoveRedRight(std::unique_ptr<Node> &n);
-  void MoveRedLeft(std::unique_ptr<Node> &n);
-  void DeleteMin(std::unique_ptr<Node> &n);
+  void RotateRight(Node *x);
+  void RotateLeft(Node *x);
+  void Transplant(Node *u, Node *v);
+  void InsertFixUp(Node *z);
+  void EraseFixUp(Node *x, Node *x_prt);
 };
 
-template <typename K, typename V>
-unsigned int Map<K, V>::Size() {
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+template <typename Iter>
+Map<K, V, Alloc, Stats>::Map(Iter first, Iter last) {
+  BulkLoad(first, last);
+}
+
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+Map<K, V, Alloc, Stats>::~Map() {
+  Clear();
+}
+
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+unsigned int Map<K, V, Alloc, Stats>::Size() {
   return cur_size;
 }
 
-template <typename K, typename V>
-typename Map<K, V>::Node* Map<K, V>::Get(Node *n, const K &key) {
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+typename Map<K, V, Alloc, Stats>::Node*
+Map<K, V, Alloc, Stats>::Get(Node *n, const K &key) {
+  unsigned int depth = 0;
   while (n) {
+    stats.OnVisit();
+    stats.OnDepth(++depth);
     if (key == n->key)
       return n;
 
     if (key < n->key)
-      n = n->left.get();
+      n = n->left;
     else
-      n = n->right.get();
+      n = n->right;
   }
   return nullptr;
 }
 
-template <typename K, typename V>
-const V& Map<K, V>::Get(const K &key) {
-  Node *n = Get(root.get(), key);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+const V& Map<K, V, Alloc, Stats>::Get(const K &key) {
+  Node *n = Get(root, key);
   if (!n)
     throw std::runtime_error("Error: cannot find key");
   return n->value;
 }
 
-template <typename K, typename V>
-bool Map<K, V>::Contains(const K &key) {
-  return Get(root.get(), key) != nullptr;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+bool Map<K, V, Alloc, Stats>::Contains(const K &key) {
+  return Get(root, key) != nullptr;
 }
 
-template <typename K, typename V>
-const K& Map<K, V>::Max(void) {
-  Node *n = root.get();
-  while (n->right) n = n->right.get();
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+const K& Map<K, V, Alloc, Stats>::Max(void) {
+  Node *n = root;
+  while (n->right) {
+    stats.OnVisit();
+    n = n->right;
+  }
   return n->key;
 }
 
-template <typename K, typename V>
-const K& Map<K, V>::Min(void) {
-  return Min(root.get())->key;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+const K& Map<K, V, Alloc, Stats>::Min(void) {
+  return leftmost->key;
 }
 
-template <typename K, typename V>
-typename Map<K, V>::Node* Map<K, V>::Min(Node *n) {
-  if (n->left)
-    return Min(n->left.get());
-  else
-    return n;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+typename Map<K, V, Alloc, Stats>::Node*
+Map<K, V, Alloc, Stats>::Min(Node *n) {
+  while (n->left) {
+    stats.OnVisit();
+    n = n->left;
+  }
+  return n;
 }
 
-template <typename K, typename V>
-bool Map<K, V>::IsRed(Node *n) {
-  if (!n) return false;
-  return (n->color == RED);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+typename Map<K, V, Alloc, Stats>::Node*
+Map<K, V, Alloc, Stats>::Next(Node *n) {
+  if (n->right)
+    return Min(n->right);
+  Node *prt = n->parent;
+  while (prt && n == prt->right) {
+    n = prt;
+    prt = prt->parent;
+  }
+  return prt;
 }
 
-template <typename K, typename V>
-void Map<K, V>::FlipColors(Node *n) {
-  n->color = !n->color;
-  n->left->color = !n->left->color;
-  n->right->color = !n->right->color;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+bool Map<K, V, Alloc, Stats>::IsRed(Node *n) {
+  if (!n) return false;
+  return (n->color == RED);
 }
 
-template <typename K, typename V>
-void Map<K, V>::RotateRight(std::unique_ptr<Node> &prt) {
-  std::unique_ptr<Node> chd = std::move(prt->left);
-  prt->left = std::move(chd->right);
-  chd->color = prt->color;
-  prt->color = RED;
-  chd->right = std::move(prt);
-  prt = std::move(chd);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::RotateRight(Node *x) {
+  Node *chd = x->left;
+  x->left = chd->right;
+  if (chd->right)
+    chd->right->parent = x;
+  Transplant(x, chd);
+  chd->right = x;
+  x->parent = chd;
+  stats.OnRotate();
 }
 
-template <typename K, typename V>
-void Map<K, V>::RotateLeft(std::unique_ptr<Node> &prt) {
-  std::unique_ptr<Node> chd = std::move(prt->right);
-  prt->right = std::move(chd->left);
-  chd->color = prt->color;
-  prt->color = RED;
-  chd->left = std::move(prt);
-  prt = std::move(chd);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::RotateLeft(Node *x) {
+  Node *chd = x->right;
+  x->right = chd->left;
+  if (chd->left)
+    chd->left->parent = x;
+  Transplant(x, chd);
+  chd->left = x;
+  x->parent = chd;
+  stats.OnRotate();
 }
 
-template <typename K, typename V>
-void Map<K, V>::FixUp(std::unique_ptr<Node> &n) {
-  // Rotate left if there is a right-leaning red node
-  if (IsRed(n->right.get()) && !IsRed(n->left.get()))
-    RotateLeft(n);
-  // Rotate right if red-red pair of nodes on left
-  if (IsRed(n->left.get()) && IsRed(n->left->left.get()))
-    RotateRight(n);
-  // Recoloring if both children are red
-  if (IsRed(n->left.get()) && IsRed(n->right.get()))
-    FlipColors(n.get());
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Transplant(Node *u, Node *v) {
+  if (!u->parent)
+    root = v;
+  else if (u == u->parent->left)
+    u->parent->left = v;
+  else
+    u->parent->right = v;
+  if (v)
+    v->parent = u->parent;
 }
 
-template <typename K, typename V>
-void Map<K, V>::MoveRedRight(std::unique_ptr<Node> &n) {
-  FlipColors(n.get());
-  if (IsRed(n->left->left.get())) {
-    RotateRight(n);
-    FlipColors(n.get());
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::InsertFixUp(Node *z) {
+  while (IsRed(z->parent)) {
+    Node *prt = z->parent;
+    Node *grand = prt->parent;
+    if (prt == grand->left) {
+      Node *uncle = grand->right;
+      if (IsRed(uncle)) {
+        prt->color = BLACK;
+        uncle->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        if (z == prt->right) {
+          z = prt;
+          RotateLeft(z);
+          prt = z->parent;
+        }
+        prt->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(2);
+        RotateRight(grand);
+      }
+    } else {
+      Node *uncle = grand->left;
+      if (IsRed(uncle)) {
+        prt->color = BLACK;
+        uncle->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        if (z == prt->left) {
+          z = prt;
+          RotateRight(z);
+          prt = z->parent;
+        }
+        prt->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(grand);
+      }
+    }
   }
+  root->color = BLACK;
 }
 
-template <typename K, typename V>
-void Map<K, V>::MoveRedLeft(std::unique_ptr<Node> &n) {
-  FlipColors(n.get());
-  if (IsRed(n->right->left.get())) {
-    RotateRight(n->right);
-    RotateLeft(n);
-    FlipColors(n.get());
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::EraseFixUp(Node *x, Node *x_prt) {
+  while (x != root && !IsRed(x)) {
+    if (x == x_prt->left) {
+      Node *sib = x_prt->right;
+      if (IsRed(sib)) {
+        sib->color = BLACK;
+        x_prt->color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(x_prt);
+        sib = x_prt->right;
+      }
+      if (!IsRed(sib->left) && !IsRed(sib->right)) {
+        sib->color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = x->parent;
+      } else {
+        if (!IsRed(sib->right)) {
+          sib->left->color = BLACK;
+          sib->color = RED;
+          stats.OnRecolor(2);
+          RotateRight(sib);
+          sib = x_prt->right;
+        }
+        sib->color = x_prt->color;
+        x_prt->color = BLACK;
+        sib->right->color = BLACK;
+        stats.OnRecolor(3);
+        RotateLeft(x_prt);
+        x = root;
+      }
+    } else {
+      Node *sib = x_prt->left;
+      if (IsRed(sib)) {
+        sib->color = BLACK;
+        x_prt->color = RED;
+        stats.OnRecolor(2);
+        RotateRight(x_prt);
+        sib = x_prt->left;
+      }
+      if (!IsRed(sib->left) && !IsRed(sib->right)) {
+        sib->color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = x->parent;
+      } else {
+        if (!IsRed(sib->left)) {
+          sib->right->color = BLACK;
+          sib->color = RED;
+          stats.OnRecolor(2);
+          RotateLeft(sib);
+          sib = x_prt->left;
+        }
+        sib->color = x_prt->color;
+        x_prt->color = BLACK;
+        sib->left->color = BLACK;
+        stats.OnRecolor(3);
+        RotateRight(x_prt);
+        x = root;
+      }
+    }
+  }
+  if (IsRed(x)) {
+    x->color = BLACK;
+    stats.OnRecolor(1);
   }
 }
 
-template <typename K, typename V>
-void Map<K, V>::DeleteMin(std::unique_ptr<Node> &n) {
-  // No left child, min is 'n'
-  if (!n->left) {
-    // Remove n
-    n = nullptr;
-    return;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Erase(Node *z) {
+  bool removed_color = z->color;
+  Node *x, *x_prt;
+  if (!z->left) {
+    x = z->right;
+    x_prt = z->parent;
+    Transplant(z, z->right);
+  } else if (!z->right) {
+    x = z->left;
+    x_prt = z->parent;
+    Transplant(z, z->left);
+  } else {
+    Node *y = Min(z->right);
+    removed_color = y->color;
+    x = y->right;
+    if (y->parent == z) {
+      x_prt = y;
+    } else {
+      x_prt = y->parent;
+      Transplant(y, y->right);
+      y->right = z->right;
+      y->right->parent = y;
+    }
+    Transplant(z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    y->color = z->color;
   }
-
-  if (!IsRed(n->left.get()) && !IsRed(n->left->left.get()))
-    MoveRedLeft(n);
-
-  DeleteMin(n->left);
-
-  FixUp(n);
+  alloc.Deallocate(z);
+  if (removed_color == BLACK)
+    EraseFixUp(x, x_prt);
 }
 
-template <typename K, typename V>
-void Map<K, V>::Remove(const K &key) {
-  if (!Contains(key))
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Remove(const K &key) {
+  Node *n = Get(root, key);
+  if (!n)
     return;
-  Remove(root, key);
+  stats.OnRemove();
+  if (n == leftmost)
+    leftmost = Next(n);
+  Erase(n);
   cur_size--;
-  if (root)
-    root->color = BLACK;
 }
 
-template <typename K, typename V>
-void Map<K, V>::Remove(std::unique_ptr<Node> &n, const K &key) {
-  // Key not found
-  if (!n) return;
-
-  if (key < n->key) {
-    if (!IsRed(n->left.get()) && !IsRed(n->left->left.get()))
-      MoveRedLeft(n);
-    Remove(n->left, key);
-  } else {
-    if (IsRed(n->left.get()))
-      RotateRight(n);
-
-    if (key == n->key && !n->right) {
-      // Remove n
-      n = nullptr;
-      return;
-    }
-
-    if (!IsRed(n->right.get()) && !IsRed(n->right->left.get()))
-      MoveRedRight(n);
-
-    if (key == n->key) {
-      // Find min node in the right subtree
-      Node *n_min = Min(n->right.get());
-      // Copy content from min node
-      n->key = n_min->key;
-      n->value = n_min->value;
-      // Delete min node recursively
-      DeleteMin(n->right);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Insert(const K &key, const V &value) {
+  Node *prt = nullptr;
+  Node **link = &root;
+  bool is_min = true;
+  unsigned int depth = 0;
+  while (*link) {
+    prt = *link;
+    stats.OnVisit();
+    depth++;
+    if (key < prt->key) {
+      link = &prt->left;
+    } else if (key > prt->key) {
+      link = &prt->right;
+      is_min = false;
     } else {
-      Remove(n->right, key);
+      throw std::runtime_error("Key already inserted");
     }
   }
-
-  FixUp(n);
+  stats.OnInsert();
+  stats.OnDepth(depth + 1);
+  Node *n = alloc.Allocate(key, value, RED);
+  n->parent = prt;
+  *link = n;
+  if (is_min)
+    leftmost = n;
+  cur_size++;
+  InsertFixUp(n);
 }
 
-template <typename K, typename V>
-void Map<K, V>::Insert(const K &key, const V &value) {
-  Insert(root, key, value);
-  cur_size++;
-  root->color = BLACK;
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+template <typename Iter>
+void Map<K, V, Alloc, Stats>::BulkLoad(Iter first, Iter last) {
+  if (first != last) {
+    for (Iter prev = first, it = std::next(first); it != last; prev = it++) {
+      if (it->first < prev->first)
+        throw std::runtime_error("Error: bulk load range is not sorted");
+      if (!(prev->first < it->first))
+        throw std::runtime_error("Key already inserted");
+    }
+  }
+  Clear();
+  Node *head = nullptr, *tail = nullptr;
+  for (; first != last; ++first) {
+    Node *n = alloc.Allocate(first->first, first->second, BLACK);
+    if (tail)
+      tail->right = n;
+    else
+      head = n;
+    tail = n;
+    stats.OnInsert();
+    cur_size++;
+  }
+  root = Build(head, cur_size);
+  leftmost = head;
 }
 
-template <typename K, typename V>
-void Map<K, V>::Insert(std::unique_ptr<Node> &n,
-                       const K &key, const V &value) {
-  if (!n)
-    n = std::unique_ptr<Node>(new Node{key, value, RED});
-  else if (key < n->key)
-    Insert(n->left, key, value);
-  else if (key > n->key)
-    Insert(n->right, key, value);
-  else
-    throw std::runtime_error("Key already inserted");
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+typename Map<K, V, Alloc, Stats>::Node*
+Map<K, V, Alloc, Stats>::Build(Node *chain, unsigned int count) {
+  unsigned int height = 0;
+  for (unsigned int c = count; c; c >>= 1)
+    height++;
+  stats.OnDepth(height);
+  unsigned int red_depth = (count & (count + 1)) ? height : 0;
+
+  // Frames wait for their left subtree (node null) or their right one
+  struct Frame {
+    Node *node;
+    unsigned int right_count;
+    unsigned int depth;
+  } stack[8 * sizeof(count) + 1];
+  int top = 0;
+  unsigned int depth = 1;
+  Node *done;
+  for (;;) {
+    while (count) {
+      unsigned int left_count = count / 2;
+      stack[top++] = Frame{nullptr, count - 1 - left_count, depth++};
+      count = left_count;
+    }
+    done = nullptr;
+    while (top && stack[top - 1].node) {
+      Node *n = stack[--top].node;
+      n->right = done;
+      if (done)
+        done->parent = n;
+      done = n;
+    }
+    if (!top)
+      break;
+    Frame &f = stack[top - 1];
+    Node *n = chain;
+    chain = chain->right;
+    n->left = done;
+    if (done)
+      done->parent = n;
+    n->color = f.depth == red_depth ? RED : BLACK;
+    f.node = n;
+    count = f.right_count;
+    depth = f.depth + 1;
+  }
+  if (done)
+    done->parent = nullptr;
+  return done;
+}
 
-  FixUp(n);
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Clear() {
+  Node *n = root;
+  while (n) {
+    if (n->left) {
+      Node *l = n->left;
+      n->left = l->right;
+      l->right = n;
+      n = l;
+    } else {
+      Node *r = n->right;
+      alloc.Deallocate(n);
+      n = r;
+    }
+  }
+  root = nullptr;
+  leftmost = nullptr;
+  cur_size = 0;
 }
 
-template <typename K, typename V>
-void Map<K, V>::Print() {
-  Print(root.get());
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+void Map<K, V, Alloc, Stats>::Print() {
+  for (Node *n = leftmost; n; n = Next(n))
+    std::cout << "<" << n->key << "," << n->value << "> ";
   std::cout << std::endl;
 }
 
-template <typename K, typename V>
-void Map<K, V>::Print(Node *n) {
-  if (!n) return;
-  Print(n->left.get());
-  std::cout << "<" << n->key << "," << n->value << "> ";
-  Print(n->right.get());
+template <typename K, typename V, template <typename> class Alloc,
+          typename Stats>
+const Stats& Map<K, V, Alloc, Stats>::GetStats() {
+  return stats;
 }
 
 #endif  // MAP_H_
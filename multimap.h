@@ -3,31 +3,120 @@
 // 917006087
 // ECS 36C - 05/22/2020
 //
-// multimap.h - Implementation of the multimap ADT using a LLRB Tree
-// Public API: Size, Get, Contains, Max, Min,
-//             Insert, Remove, Print
-// Iterative Helper: Get
-// Recursive Helpers: Min, Insert, Remove, Print
-// Self-Balancing Helpers: IsRed, FlipColors, RotateRight, RotateLeft,
-//                         FixUp, MoveRedRight, MoveRedLeft, DeleteMin
+// multimap.h - Implementation of the multimap ADT using a RB Tree with
+// parent links; every operation walks the tree iteratively and restores
+// balance bottom-up (at most 2 rotations per insert, 3 per removal)
+// Public API: Size, Get, Front, Contains, Max, Min, Insert, Remove,
+//             PopMin, BulkLoad, Clear, Print, GetStats, begin, end,
+//             LowerBound, UpperBound, EqualRange, ForEach
+// Iterative Helpers: Get, Min, Max, Next, Prev, Erase, DeleteMin, Build
+// Self-Balancing Helpers: IsRed, RotateRight, RotateLeft, Transplant,
+//                         InsertFixUp, EraseFixUp
 //
 
 #ifndef MULTIMAP_H_
 #define MULTIMAP_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
-#include <deque>
 
-template <typename K, typename V>
+#include "node_allocator.h"
+#include "small_queue.h"
+#include "tree_stats.h"
+
+// @Alloc is the node allocation policy (see node_allocator.h)
+// @N is the # of values per key stored inline before spilling to the heap
+// @Stats is the instrumentation policy (see tree_stats.h)
+template <typename K, typename V,
+          template <typename> class Alloc = HeapAllocator, std::size_t N = 1,
+          typename Stats = NoTreeStats>
 class Multimap {
+  struct Node;
+
  public:
+  // const_iterator - walk (key, value) pairs in key order, the values of
+  //                  a key front to back, along parent links without
+  //                  recursion or allocation
+  class const_iterator {
+   public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef V value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const V* pointer;
+    typedef const V& reference;
+
+    const_iterator(void) = default;
+    reference operator*() const { return node->values[index]; }
+    pointer operator->() const { return &node->values[index]; }
+    // key - return key of the current value
+    const K& key() const { return node->key; }
+
+    const_iterator& operator++() {
+      if (++index == node->values.size()) {
+        node = tree->Next(node);
+        index = 0;
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    // operator-- - step back, from end() onto the last value
+    const_iterator& operator--() {
+      if (index == 0) {
+        node = node ? tree->Prev(node) : tree->Max(tree->root);
+        index = static_cast<uint32_t>(node->values.size());
+      }
+      index--;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      --*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator &o) const {
+      return node == o.node && index == o.index;
+    }
+    bool operator!=(const const_iterator &o) const {
+      return !(*this == o);
+    }
+
+   private:
+    friend class Multimap;
+    const_iterator(Multimap *t, Node *n) : tree(t), node(n) {}
+
+    Multimap *tree = nullptr;
+    // Current node & position in its values, node null past the end
+    Node *node = nullptr;
+    uint32_t index = 0;
+  };
+
+  Multimap(void) = default;
+  // Build tree from (key, value) pairs in [@first, @last) sorted by key
+  template <typename Iter>
+  Multimap(Iter first, Iter last);
+  Multimap(const Multimap&) = delete;
+  Multimap& operator=(const Multimap&) = delete;
+  // Free all nodes on destruction
+  ~Multimap(void);
+
   // Return size of tree
   unsigned int Size();
   // Return value associated to @key
   const V& Get(const K& key);
+  // Return first value associated to min key
+  const V& Front();
   // Return whether @key is found in tree
   bool Contains(const K& key);
   // Return max key in tree
@@ -38,8 +127,34 @@ class Multimap {
   void Insert(const K &key, const V &value);
   // Remove @key from tree
   void Remove(const K &key);
-  // Print tree in-order
-  void Print();
+  // Remove first @value of @key from tree; return false if not found
+  bool Remove(const K &key, const V &value);
+  // Remove & return first value of min key, storing new min key in @next_min
+  V PopMin(K *next_min = nullptr);
+  // Replace contents with (key, value) pairs in [@first, @last) sorted by
+  // key, in linear time
+  template <typename Iter>
+  void BulkLoad(Iter first, Iter last);
+  // Remove all keys from tree
+  void Clear();
+  // Print tree in-order to @os
+  void Print(std::ostream &os = std::cout);
+  // Return counters kept by the Stats policy since construction
+  const Stats& GetStats();
+
+  // Return iterator to first value of min key
+  const_iterator begin();
+  // Return iterator past the last value of max key
+  const_iterator end();
+  // Return iterator to first value of the min key not less than @key
+  const_iterator LowerBound(const K &key);
+  // Return iterator to first value of the min key greater than @key
+  const_iterator UpperBound(const K &key);
+  // Return [LowerBound, UpperBound) of @key, all values of @key
+  std::pair<const_iterator, const_iterator> EqualRange(const K &key);
+  // Call @visit(key, value) on every pair in order
+  template <typename F>
+  void ForEach(F visit);
 
  private:
   enum Color { RED, BLACK };
@@ -49,44 +164,66 @@ class Multimap {
   struct Node {
     bool color;
     K key;
-    std::deque<V> values;
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> right;
+    SmallQueue<V, N> values;
+    Node *left;
+    Node *right;
+    Node *parent;
   };
-  std::unique_ptr<Node> root;
+  Node *root = nullptr;
+  // Cached min node; rotations never change which node is leftmost, so
+  // only node creation & deletion have to maintain it
+  Node *leftmost = nullptr;
   unsigned int cur_size = 0;
+  Stats stats;
+  Alloc<Node> alloc;
 
   // Iterative helper methods
   Node* Get(Node *n, const K &key);
-
-  // Recursive helper methods
   Node* Min(Node *n);
-  void Insert(std::unique_ptr<Node> &n, const K &key, const V &value);
-  void Remove(std::unique_ptr<Node> &n, const K &key);
-  void Print(Node *n);
+  Node* Max(Node *n);
+  Node* Next(Node *n);
+  Node* Prev(Node *n);
+  void Erase(Node *z);
+  Node* DeleteMin();
+  Node* Build(Node *chain, unsigned int count);
 
   // Helper methods for the self-balancing
   bool IsRed(Node *n);
-  void FlipColors(Node *n);
-  void RotateRight(std::unique_ptr<Node> &prt);
-  void RotateLeft(std::unique_ptr<Node> &prt);
-  void FixUp(std::unique_ptr<Node> &n);
-  void MoveRedRight(std::unique_ptr<Node> &n);
-  void MoveRedLeft(std::unique_ptr<Node> &n);
-  void DeleteMin(std::unique_ptr<Node> &n);
+  void RotateRight(Node *x);
+  void RotateLeft(Node *x);
+  void Transplant(Node *u, Node *v);
+  void InsertFixUp(Node *z);
+  void EraseFixUp(Node *x, Node *x_prt);
 };
 
+// Multimap() - build tree from sorted pairs in [@first, @last)
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+template <typename Iter>
+Multimap<K, V, Alloc, N, Stats>::Multimap(Iter first, Iter last) {
+  BulkLoad(first, last);
+}
+
+// ~Multimap() - release every node through the allocator
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+Multimap<K, V, Alloc, N, Stats>::~Multimap(void) {
+  Clear();
+}
+
 // Size - return current size of multimap
-template <typename K, typename V>
-unsigned int Multimap<K, V>::Size() {
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+unsigned int Multimap<K, V, Alloc, N, Stats>::Size() {
   return cur_size;
 }
 
 // Get - call helper method to attain @value stored @key;
-template <typename K, typename V>
-const V& Multimap<K, V>::Get(const K &key) {
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+const V& Multimap<K, V, Alloc, N, Stats>::Get(const K &key) {
   // Start at root node and begin binary traversal with helper
-  Node *n = Get(root.get(), key);
+  Node *n = Get(root, key);
   // Ensure that key is found
   if (!n)
     throw std::runtime_error("Error: cannot find key");
@@ -96,274 +233,694 @@ const V& Multimap<K, V>::Get(const K &key) {
 
 // HELPER METHOD - traverse until node @key is found or not
 //                 updated to return first element in values list
-template <typename K, typename V>
-typename Multimap<K, V>::Node* Multimap<K, V>::Get(Node *n, const K &key) {
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Get(Node *n, const K &key) {
   // Loop through using binary search for @key
+  unsigned int depth = 0;
   while (n) {
+    stats.OnVisit();
+    stats.OnDepth(++depth);
     // IF key matches
     if (key == n->key)
       return n;
     // Key on LEFT
     if (key < n->key)
-      n = n->left.get();
+      n = n->left;
     // Key on RIGHT
     else
-      n = n->right.get();
+      n = n->right;
   }
   return nullptr;
 }
 
 // Contains - uses get helper to check if @key is found
-template <typename K, typename V>
-bool Multimap<K, V>::Contains(const K &key) {
-  return Get(root.get(), key) != nullptr;
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+bool Multimap<K, V, Alloc, N, Stats>::Contains(const K &key) {
+  return Get(root, key) != nullptr;
 }
 
 // Max - iterative traversal right to attain max @key
-template <typename K, typename V>
-const K& Multimap<K, V>::Max(void) {
-  Node *n = root.get();
-  // Start at root and go all right
-  while (n->right) n = n->right.get();
-  return n->key;
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+const K& Multimap<K, V, Alloc, N, Stats>::Max(void) {
+  return Max(root)->key;
+}
+
+// Front - return first value of cached min node
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+const V& Multimap<K, V, Alloc, N, Stats>::Front(void) {
+  // Ensure that multimap isn't empty
+  if (!leftmost)
+    throw std::runtime_error("Error: cannot get front of empty multimap");
+  return leftmost->values.front();
 }
 
-// Min - call helper method to attain min @key
-template <typename K, typename V>
-const K& Multimap<K, V>::Min(void) {
-  return Min(root.get())->key;
+// Min - return @key of cached min node
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+const K& Multimap<K, V, Alloc, N, Stats>::Min(void) {
+  return leftmost->key;
 }
 
 // HELPER METHOD - traverse all the way left for min node
-template <typename K, typename V>
-typename Multimap<K, V>::Node* Multimap<K, V>::Min(Node *n) {
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Min(Node *n) {
+  while (n->left) {
+    stats.OnVisit();
+    n = n->left;
+  }
+  return n;
+}
+
+// HELPER METHOD - traverse all the way right for max node
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Max(Node *n) {
+  while (n->right) {
+    stats.OnVisit();
+    n = n->right;
+  }
+  return n;
+}
+
+// HELPER METHOD - return in-order successor of @n (null if last)
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Next(Node *n) {
+  // Successor is min of right subtree if there is one
+  if (n->right)
+    return Min(n->right);
+  // Otherwise climb until coming up from a left child
+  Node *prt = n->parent;
+  while (prt && n == prt->right) {
+    n = prt;
+    prt = prt->parent;
+  }
+  return prt;
+}
+
+// HELPER METHOD - return in-order predecessor of @n (null if first)
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Prev(Node *n) {
+  // Predecessor is max of left subtree if there is one
   if (n->left)
-    return Min(n->left.get());
-  else
-    return n;
+    return Max(n->left);
+  // Otherwise climb until coming up from a right child
+  Node *prt = n->parent;
+  while (prt && n == prt->left) {
+    n = prt;
+    prt = prt->parent;
+  }
+  return prt;
 }
 
 // IsRed - check if current node is red
-template <typename K, typename V>
-bool Multimap<K, V>::IsRed(Node *n) {
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+bool Multimap<K, V, Alloc, N, Stats>::IsRed(Node *n) {
   // NIL nodes are black
   if (!n) return false;
   // Regular nodes
   return (n->color == RED);
 }
 
-// FlipColors - case 2, inverting colors of current node & children
-template <typename K, typename V>
-void Multimap<K, V>::FlipColors(Node *n) {
-  n->color = !n->color;
-  n->left->color = !n->left->color;
-  n->right->color = !n->right->color;
-}
-
-// RotateRight - perform standard right rotation
-template <typename K, typename V>
-void Multimap<K, V>::RotateRight(std::unique_ptr<Node> &prt) {
+// RotateRight - perform standard right rotation around @x
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::RotateRight(Node *x) {
   // Obtain left child
-  std::unique_ptr<Node> chd = std::move(prt->left);
+  Node *chd = x->left;
   // Give original parent child's right
-  prt->left = std::move(chd->right);
-  chd->color = prt->color;
-  prt->color = RED;
-  // Child & parent invert positions
-  chd->right = std::move(prt);
-  prt = std::move(chd);
+  x->left = chd->right;
+  if (chd->right)
+    chd->right->parent = x;
+  // Child takes parent's place, parent goes down right
+  Transplant(x, chd);
+  chd->right = x;
+  x->parent = chd;
+  stats.OnRotate();
 }
 
-// RotateLeft - perform standard left rotation
-template <typename K, typename V>
-void Multimap<K, V>::RotateLeft(std::unique_ptr<Node> &prt) {
+// RotateLeft - perform standard left rotation around @x
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::RotateLeft(Node *x) {
   // Obtain right child
-  std::unique_ptr<Node> chd = std::move(prt->right);
+  Node *chd = x->right;
   // Give original parent child's left
-  prt->right = std::move(chd->left);
-  chd->color = prt->color;
-  prt->color = RED;
-  // Child & parent invert positions
-  chd->left = std::move(prt);
-  prt = std::move(chd);
-}
-
-// FixUp - recursion traversal back up the RB-Tree;
-//         handle (3a) simple rot, (3b) complex rot, (2) recoloring
-template <typename K, typename V>
-void Multimap<K, V>::FixUp(std::unique_ptr<Node> &n) {
-  // Rotate left if there is a right-leaning red node
-  if (IsRed(n->right.get()) && !IsRed(n->left.get()))
-    RotateLeft(n);
-  // Rotate right if red-red pair of nodes on left
-  if (IsRed(n->left.get()) && IsRed(n->left->left.get()))
-    RotateRight(n);
-  // Recoloring if both children are red
-  if (IsRed(n->left.get()) && IsRed(n->right.get()))
-    FlipColors(n.get());
-}
-
-// MoveRedRight - search path goes RIGHT, operate if left-left child red
-template <typename K, typename V>
-void Multimap<K, V>::MoveRedRight(std::unique_ptr<Node> &n) {
-  // Flip current node & children colors
-  FlipColors(n.get());
-  // If left-left child is RED, RR, Flip
-  if (IsRed(n->left->left.get())) {
-    RotateRight(n);
-    FlipColors(n.get());
+  x->right = chd->left;
+  if (chd->left)
+    chd->left->parent = x;
+  // Child takes parent's place, parent goes down left
+  Transplant(x, chd);
+  chd->left = x;
+  x->parent = chd;
+  stats.OnRotate();
+}
+
+// Transplant - hang @v (may be null) where @u hangs under its parent
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Transplant(Node *u, Node *v) {
+  if (!u->parent)
+    root = v;
+  else if (u == u->parent->left)
+    u->parent->left = v;
+  else
+    u->parent->right = v;
+  if (v)
+    v->parent = u->parent;
+}
+
+// InsertFixUp - climb from new red node @z resolving red-red violations:
+//               (2) recolor when uncle is red, (3) rotate when black
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::InsertFixUp(Node *z) {
+  while (IsRed(z->parent)) {
+    // A red parent is never the root, so grandparent exists
+    Node *prt = z->parent;
+    Node *grand = prt->parent;
+    // Parent on LEFT
+    if (prt == grand->left) {
+      Node *uncle = grand->right;
+      // (2) Recoloring, push violation up to grandparent
+      if (IsRed(uncle)) {
+        prt->color = BLACK;
+        uncle->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        // (3b) Complex rotation, straighten zig-zag first
+        if (z == prt->right) {
+          z = prt;
+          RotateLeft(z);
+          prt = z->parent;
+        }
+        // (3a) Simple rotation
+        prt->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(2);
+        RotateRight(grand);
+      }
+    // Parent on RIGHT, mirror image
+    } else {
+      Node *uncle = grand->left;
+      if (IsRed(uncle)) {
+        prt->color = BLACK;
+        uncle->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(3);
+        z = grand;
+      } else {
+        if (z == prt->left) {
+          z = prt;
+          RotateRight(z);
+          prt = z->parent;
+        }
+        prt->color = BLACK;
+        grand->color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(grand);
+      }
+    }
   }
+  root->color = BLACK;
 }
 
-// MoveRedLeft - search path goes LEFT, operate if right-left child red
-template <typename K, typename V>
-void Multimap<K, V>::MoveRedLeft(std::unique_ptr<Node> &n) {
-  // Flip current node & children colors
-  FlipColors(n.get());
-  // If right-left child is RED, RR, RL, Flip
-  if (IsRed(n->right->left.get())) {
-    RotateRight(n->right);
-    RotateLeft(n);
-    FlipColors(n.get());
+// EraseFixUp - climb from @x (may be null, hence @x_prt) which is short
+//              one black node, borrowing from or recoloring its sibling
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::EraseFixUp(Node *x, Node *x_prt) {
+  while (x != root && !IsRed(x)) {
+    // x on LEFT
+    if (x == x_prt->left) {
+      Node *sib = x_prt->right;
+      // Red sibling, rotate so sibling is black
+      if (IsRed(sib)) {
+        sib->color = BLACK;
+        x_prt->color = RED;
+        stats.OnRecolor(2);
+        RotateLeft(x_prt);
+        sib = x_prt->right;
+      }
+      // Black sibling with black children, recolor & move up
+      if (!IsRed(sib->left) && !IsRed(sib->right)) {
+        sib->color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = x->parent;
+      } else {
+        // Far child black, rotate near red child into its place
+        if (!IsRed(sib->right)) {
+          sib->left->color = BLACK;
+          sib->color = RED;
+          stats.OnRecolor(2);
+          RotateRight(sib);
+          sib = x_prt->right;
+        }
+        // Far child red, final rotation restores black height
+        sib->color = x_prt->color;
+        x_prt->color = BLACK;
+        sib->right->color = BLACK;
+        stats.OnRecolor(3);
+        RotateLeft(x_prt);
+        x = root;
+      }
+    // x on RIGHT, mirror image
+    } else {
+      Node *sib = x_prt->left;
+      if (IsRed(sib)) {
+        sib->color = BLACK;
+        x_prt->color = RED;
+        stats.OnRecolor(2);
+        RotateRight(x_prt);
+        sib = x_prt->left;
+      }
+      if (!IsRed(sib->left) && !IsRed(sib->right)) {
+        sib->color = RED;
+        stats.OnRecolor(1);
+        x = x_prt;
+        x_prt = x->parent;
+      } else {
+        if (!IsRed(sib->left)) {
+          sib->right->color = BLACK;
+          sib->color = RED;
+          stats.OnRecolor(2);
+          RotateLeft(sib);
+          sib = x_prt->left;
+        }
+        sib->color = x_prt->color;
+        x_prt->color = BLACK;
+        sib->left->color = BLACK;
+        stats.OnRecolor(3);
+        RotateRight(x_prt);
+        x = root;
+      }
+    }
+  }
+  if (IsRed(x)) {
+    x->color = BLACK;
+    stats.OnRecolor(1);
   }
 }
 
-// DeleteMin - delete min node and recurse back up to restore RB
-template <typename K, typename V>
-void Multimap<K, V>::DeleteMin(std::unique_ptr<Node> &n) {
-  // No left child, min is 'n'
-  if (!n->left) {
-    // Remove n
-    n = nullptr;
-    return;
+// HELPER METHOD - unlink node @z from the tree & free it; nodes are
+//                 relinked rather than copied so other nodes stay put
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Erase(Node *z) {
+  // Node whose color leaves its position & node that moves into it
+  bool removed_color = z->color;
+  Node *x, *x_prt;
+  // (1) At most one child, splice z out
+  if (!z->left) {
+    x = z->right;
+    x_prt = z->parent;
+    Transplant(z, z->right);
+  } else if (!z->right) {
+    x = z->left;
+    x_prt = z->parent;
+    Transplant(z, z->left);
+  // (2) Two children, successor y takes z's place & color
+  } else {
+    Node *y = Min(z->right);
+    removed_color = y->color;
+    x = y->right;
+    if (y->parent == z) {
+      x_prt = y;
+    } else {
+      x_prt = y->parent;
+      Transplant(y, y->right);
+      y->right = z->right;
+      y->right->parent = y;
+    }
+    Transplant(z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    y->color = z->color;
   }
-  // Push red link down if necessary
-  if (!IsRed(n->left.get()) && !IsRed(n->left->left.get()))
-    MoveRedLeft(n);
-  // Continue traversing down left
-  DeleteMin(n->left);
-  // Fix restructuring & recoloring
-  FixUp(n);
-}
-
-// Remove - call helper method to remove @key & @value pair
-template <typename K, typename V>
-void Multimap<K, V>::Remove(const K &key) {
+  alloc.Deallocate(z);
+  // Removing a black node shortens one path, restore black height
+  if (removed_color == BLACK)
+    EraseFixUp(x, x_prt);
+}
+
+// DeleteMin - delete cached min node & return the new one (null if empty)
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::DeleteMin(void) {
+  Node *n = leftmost;
+  leftmost = Next(n);
+  Erase(n);
+  return leftmost;
+}
+
+// PopMin - remove first value of min key & return it; a lone value takes
+//          its node with it through DeleteMin, which hands back new min
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+V Multimap<K, V, Alloc, N, Stats>::PopMin(K *next_min) {
+  // Ensure that multimap isn't empty
+  if (!root)
+    throw std::runtime_error("Error: cannot pop from empty multimap");
+  stats.OnRemove();
+  Node *n_min = leftmost;
+  V value = std::move(n_min->values.front());
+  // a) Remove 1 key-value pair, min key unchanged
+  if (n_min->values.size() > 1)
+    n_min->values.pop_front();
+  // b) Remove entire min node
+  else
+    n_min = DeleteMin();
+  cur_size--;
+  // Report new min key
+  if (next_min && n_min)
+    *next_min = n_min->key;
+  return value;
+}
+
+// Remove - remove first value of @key, dropping its node once empty
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Remove(const K &key) {
   // Check to make sure multimap contains @key
-  if (!Contains(key))
+  Node *n = Get(root, key);
+  if (!n)
     return;
-  // Go about with removal
-  Remove(root, key);
-  // Decrement Multimap size and make root black
+  stats.OnRemove();
+  // a) Remove 1 key-value pair
+  if (n->values.size() > 1) {
+    n->values.pop_front();
+  // b) Remove entire node, moving cached min node along if needed
+  } else {
+    if (n == leftmost)
+      leftmost = Next(n);
+    Erase(n);
+  }
+  // Decrement Multimap size
   cur_size--;
-  if (root)
-    root->color = BLACK;
-}
-
-// HELPER METHOD - remove node with @key & @value at appropriate position;
-//                 updated to handle a list of values
-template <typename K, typename V>
-void Multimap<K, V>::Remove(std::unique_ptr<Node> &n, const K &key) {
-  // Key not found
-  if (!n) return;
-
-  // (1) LEFT case
-  if (key < n->key) {
-    // Left = BLACK, Left-Left = BLACK, search path goes LEFT
-    if (!IsRed(n->left.get()) && !IsRed(n->left->left.get()))
-      MoveRedLeft(n);
-    // Keep recursing LEFT
-    Remove(n->left, key);
-  // (2) RIGHT or EQUAL case
+}
+
+// Remove - find node of @key by binary search, then drop the first of
+//          its values equal to @value; a scan of that key's values only
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+bool Multimap<K, V, Alloc, N, Stats>::Remove(const K &key, const V &value) {
+  Node *n = Get(root, key);
+  if (!n)
+    return false;
+  std::size_t i = 0;
+  while (i < n->values.size() && !(n->values[i] == value))
+    i++;
+  if (i == n->values.size())
+    return false;
+  stats.OnRemove();
+  // a) Remove 1 key-value pair
+  if (n->values.size() > 1) {
+    n->values.erase(i);
+  // b) Remove entire node, moving cached min node along if needed
   } else {
-    // Left = RED
-    if (IsRed(n->left.get()))
-      RotateRight(n);
-    // EQUAL - *at bottom*, delete key-value pair
-    if (key == n->key && !n->right) {
-      // a) Remove 1 key-value pair
-      if (n->values.size() > 1)
-        n->values.pop_front();
-      // b) Remove entire node
-      else
-        n = nullptr;
+    if (n == leftmost)
+      leftmost = Next(n);
+    Erase(n);
+  }
+  cur_size--;
+  return true;
+}
+
+// Insert - walk down to @key & attach a new red node or append @value to
+//          the existing list, then rebalance upwards
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Insert(const K &key, const V &value) {
+  Node *prt = nullptr;
+  Node **link = &root;
+  bool is_min = true;
+  unsigned int depth = 0;
+  stats.OnInsert();
+  // Loop through using binary search for @key
+  while (*link) {
+    prt = *link;
+    stats.OnVisit();
+    depth++;
+    // Go LEFT -> node is smaller
+    if (key < prt->key) {
+      link = &prt->left;
+    // Go RIGHT -> node is greater
+    } else if (prt->key < key) {
+      link = &prt->right;
+      is_min = false;
+    // @key already exists, push new value at end of list
+    } else {
+      stats.OnDepth(depth);
+      prt->values.push_back(value);
+      cur_size++;
       return;
     }
-    // Right = BLACK, Right-Left = BLACK, search path goes RIGHT
-    if (!IsRed(n->right.get()) && !IsRed(n->right->left.get()))
-      MoveRedRight(n);
-    // EQUAL - *not at bottom*
-    if (key == n->key) {
-      // a) Remove 1 key-value pair
-      if (n->values.size() > 1) {
-        n->values.pop_front();
-      // b) Replace by copying content from min node
-      } else {
-        // Find MIN node in the right subtree, delete it
-        Node *n_min = Min(n->right.get());
-        n->key = n_min->key;
-        n->values.swap(n_min->values);
-        DeleteMin(n->right);
-      }
+  }
+  // INSERT HERE -> no node present, add value to list
+  stats.OnDepth(depth + 1);
+  Node *n = alloc.Allocate(RED, key);
+  n->values.push_back(value);
+  n->parent = prt;
+  *link = n;
+  // Never went right -> new smallest key becomes the cached min node
+  if (is_min)
+    leftmost = n;
+  // Update current size and rebalance
+  cur_size++;
+  InsertFixUp(n);
+}
+
+// BulkLoad - replace contents with the (key, value) pairs in [@first,
+//            @last), which must be sorted by key; runs of equal keys
+//            share one node, values kept in input order
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+template <typename Iter>
+void Multimap<K, V, Alloc, N, Stats>::BulkLoad(Iter first, Iter last) {
+  // Check order up front so a bad range leaves the tree untouched
+  if (first != last) {
+    for (Iter prev = first, it = std::next(first); it != last; prev = it++)
+      if (it->first < prev->first)
+        throw std::runtime_error("Error: bulk load range is not sorted");
+  }
+  Clear();
+  // Chain one node per distinct key through right links, in order
+  Node *head = nullptr, *tail = nullptr;
+  unsigned int count = 0;
+  for (; first != last; ++first) {
+    if (!tail || tail->key < first->first) {
+      Node *n = alloc.Allocate(BLACK, first->first);
+      if (tail)
+        tail->right = n;
+      else
+        head = n;
+      tail = n;
+      count++;
+    }
+    tail->values.push_back(first->second);
+    stats.OnInsert();
+    cur_size++;
+  }
+  root = Build(head, count);
+  leftmost = head;
+}
+
+// HELPER METHOD - link the @count nodes chained through right links from
+//                 @chain into a balanced tree & return its root; nodes on
+//                 an incomplete bottom level are red, all others black
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::Node*
+Multimap<K, V, Alloc, N, Stats>::Build(Node *chain, unsigned int count) {
+  // Subtree sizes split in half, so every leaf sits on the bottom 2 levels
+  unsigned int height = 0;
+  for (unsigned int c = count; c; c >>= 1)
+    height++;
+  stats.OnDepth(height);
+  unsigned int red_depth = (count & (count + 1)) ? height : 0;
+
+  // In-order walk of the implied shape; a frame is a subtree root waiting
+  // for its left subtree (node null) or its right subtree
+  struct Frame {
+    Node *node;
+    unsigned int right_count;
+    unsigned int depth;
+  } stack[8 * sizeof(count) + 1];
+  int top = 0;
+  unsigned int depth = 1;
+  Node *done;
+  for (;;) {
+    // Descend left, splitting off the right half of each subtree
+    while (count) {
+      unsigned int left_count = count / 2;
+      stack[top++] = Frame{nullptr, count - 1 - left_count, depth++};
+      count = left_count;
+    }
+    // Empty subtree; climb past frames whose right subtree is done
+    done = nullptr;
+    while (top && stack[top - 1].node) {
+      Node *n = stack[--top].node;
+      n->right = done;
+      if (done)
+        done->parent = n;
+      done = n;
+    }
+    if (!top)
+      break;
+    // Left subtree done, take the next node in order as its parent
+    Frame &f = stack[top - 1];
+    Node *n = chain;
+    chain = chain->right;
+    n->left = done;
+    if (done)
+      done->parent = n;
+    n->color = f.depth == red_depth ? RED : BLACK;
+    f.node = n;
+    count = f.right_count;
+    depth = f.depth + 1;
+  }
+  if (done)
+    done->parent = nullptr;
+  return done;
+}
+
+// Clear - destroy every node without recursion by rotating left children
+//         up until the current node has none, then freeing it
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Clear(void) {
+  Node *n = root;
+  while (n) {
+    if (n->left) {
+      // Rotate left child above n
+      Node *l = n->left;
+      n->left = l->right;
+      l->right = n;
+      n = l;
     } else {
-      // Keep recursing RIGHT
-      Remove(n->right, key);
+      // No left child, free n & continue right
+      Node *r = n->right;
+      alloc.Deallocate(n);
+      n = r;
     }
   }
-  // Recurse back up and perform additional restructuring & recoloring
-  FixUp(n);
+  root = nullptr;
+  leftmost = nullptr;
+  cur_size = 0;
 }
 
-// Insert - call helper method to insert @key with @value
-template <typename K, typename V>
-void Multimap<K, V>::Insert(const K &key, const V &value) {
-  Insert(root, key, value);
-  // Update current size and make root black
-  cur_size++;
-  root->color = BLACK;
+// Print - walk successor links from min node to print all @key & @value
+//         pairs in-order to @os, full list of values upon each @key
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+void Multimap<K, V, Alloc, N, Stats>::Print(std::ostream &os) {
+  ForEach([&os](const K &key, const V &value) {
+    os << "<" << key << "," << value << "> ";
+  });
+  os << std::endl;
 }
 
-// HELPER METHOD - insert node with @key & @value at appropriate position;
-//                 updated to handle a list of values
-template <typename K, typename V>
-void Multimap<K, V>::Insert(std::unique_ptr<Node> &n,
-                       const K &key, const V &value) {
-  // INSERT HERE -> no node present, add value to vector
-  if (!n) {
-    // Initialize with only color & key value, vector already created
-    n = std::unique_ptr<Node>(new Node{RED, key});
-    n->values.push_back(value);
-  // Go LEFT -> node is smaller
-  } else if (key < n->key) {
-    Insert(n->left, key, value);
-  // Go RIGHT -> node is greater
-  } else if (key > n->key) {
-    Insert(n->right, key, value);
-  // @key already exists, push new value at end of list
-  } else {
-    n->values.push_back(value);
+// GetStats - return counters kept by the Stats policy
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+const Stats& Multimap<K, V, Alloc, N, Stats>::GetStats() {
+  return stats;
+}
+
+// begin - return iterator to first value of cached min node
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::const_iterator
+Multimap<K, V, Alloc, N, Stats>::begin() {
+  return const_iterator(this, leftmost);
+}
+
+// end - return iterator past the last value
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::const_iterator
+Multimap<K, V, Alloc, N, Stats>::end() {
+  return const_iterator(this, nullptr);
+}
+
+// LowerBound - binary search for the min key not less than @key
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::const_iterator
+Multimap<K, V, Alloc, N, Stats>::LowerBound(const K &key) {
+  Node *n = root, *bound = nullptr;
+  while (n) {
+    stats.OnVisit();
+    // Node qualifies, look for a smaller one on the LEFT
+    if (!(n->key < key)) {
+      bound = n;
+      n = n->left;
+    } else {
+      n = n->right;
+    }
+  }
+  return const_iterator(this, bound);
+}
+
+// UpperBound - binary search for the min key greater than @key
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+typename Multimap<K, V, Alloc, N, Stats>::const_iterator
+Multimap<K, V, Alloc, N, Stats>::UpperBound(const K &key) {
+  Node *n = root, *bound = nullptr;
+  while (n) {
+    stats.OnVisit();
+    // Node qualifies, look for a smaller one on the LEFT
+    if (key < n->key) {
+      bound = n;
+      n = n->left;
+    } else {
+      n = n->right;
+    }
+  }
+  return const_iterator(this, bound);
+}
+
+// EqualRange - return iterators around every value of @key; both equal
+//              UpperBound(@key) if @key is absent
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+std::pair<typename Multimap<K, V, Alloc, N, Stats>::const_iterator,
+          typename Multimap<K, V, Alloc, N, Stats>::const_iterator>
+Multimap<K, V, Alloc, N, Stats>::EqualRange(const K &key) {
+  const_iterator first = LowerBound(key);
+  // A single node holds every value of @key
+  if (first == end() || key < first.key())
+    return std::make_pair(first, first);
+  return std::make_pair(first, const_iterator(this, Next(first.node)));
+}
+
+// ForEach - walk successor links from min node calling @visit(key, value)
+//           on every pair in order
+template <typename K, typename V, template <typename> class Alloc,
+          std::size_t N, typename Stats>
+template <typename F>
+void Multimap<K, V, Alloc, N, Stats>::ForEach(F visit) {
+  for (Node *n = leftmost; n; n = Next(n)) {
+    for (const V &value : n->values)
+      visit(n->key, value);
   }
-  // Recurse back up and perform additional restructuring & recoloring
-  FixUp(n);
-}
-
-// Print - call helper method to print out all @key & @value pairs in in-order
-template <typename K, typename V>
-void Multimap<K, V>::Print() {
-  Print(root.get());
-  std::cout << std::endl;
-}
-
-// HELPER METHOD - recurse LNR for in-order traversal printing of @key & @value;
-//                 updated to print full list of values upon @key
-template <typename K, typename V>
-void Multimap<K, V>::Print(Node *n) {
-  if (!n) return;
-  Print(n->left.get());
-  // Print out each key-value pair
-  for (auto i : n->values)
-    std::cout << "<" << n->key << "," << i << "> ";
-  Print(n->right.get());
 }
 
 #endif  // MULTIMAP_H_
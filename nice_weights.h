@@ -0,0 +1,80 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// nice_weights.h - Load weights of the nice levels, as in the Linux
+// kernel's sched_prio_to_weight & sched_prio_to_wmult tables.
+// The inverse weights are derived from the weights at compile time so
+// charging a task for its runtime takes a multiply & a shift, never a
+// division.
+//
+
+#ifndef NICE_WEIGHTS_H_
+#define NICE_WEIGHTS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Range of nice levels
+const int kMinNice = -20;
+const int kMaxNice = 19;
+const std::size_t kNiceLevels = kMaxNice - kMinNice + 1;
+
+// Weight of a nice 0 task
+const uint32_t kNice0Load = 1024;
+
+// Weight of each nice level from kMinNice up; a level gets ~1.25x the
+// CPU of the level below it
+constexpr uint32_t kPrioToWeight[kNiceLevels] = {
+  /* -20 */ 88761, 71755, 56483, 46273, 36291,
+  /* -15 */ 29154, 23254, 18705, 14949, 11916,
+  /* -10 */  9548,  7620,  6100,  4904,  3906,
+  /*  -5 */  3121,  2501,  1991,  1586,  1277,
+  /*   0 */  1024,   820,   655,   526,   423,
+  /*   5 */   335,   272,   215,   172,   137,
+  /*  10 */   110,    87,    70,    56,    45,
+  /*  15 */    36,    29,    23,    18,    15,
+};
+
+// Indices - compile-time list of table indices
+template <std::size_t... I>
+struct Indices {};
+
+// MakeIndices - Indices<0, ..., N - 1>
+template <std::size_t N, std::size_t... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+
+template <std::size_t... I>
+struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+// WMultTable - 2^32 / weight of each nice level
+struct WMultTable {
+  uint32_t wmult[kNiceLevels];
+};
+
+// makeWMultTable - compute the inverse of every weight
+template <std::size_t... I>
+constexpr WMultTable makeWMultTable(Indices<I...>) {
+  return WMultTable{{static_cast<uint32_t>((uint64_t(1) << 32) /
+                                           kPrioToWeight[I])...}};
+}
+
+constexpr WMultTable kPrioToWMult =
+  makeWMultTable(MakeIndices<kNiceLevels>::type());
+
+// vruntimeStep - vruntime gained per tick of runtime at @nice, in 32.32
+//                fixed point: kNice0Load / weight as kNice0Load * wmult
+constexpr uint64_t vruntimeStep(int nice) {
+  return uint64_t(kNice0Load) * kPrioToWMult.wmult[nice - kMinNice];
+}
+
+static_assert(vruntimeStep(0) == uint64_t(1) << 32,
+              "a nice 0 task must gain exactly one tick of vruntime per tick");
+static_assert(vruntimeStep(kMinNice) < vruntimeStep(0) &&
+              vruntimeStep(0) < vruntimeStep(kMaxNice),
+              "lower nice levels must gain vruntime more slowly");
+
+#endif  // NICE_WEIGHTS_H_
@@ -0,0 +1,95 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// node_allocator.h - Node allocation policies for the Map & Multimap trees
+// HeapAllocator: one new/delete pair per node (default behavior)
+// PoolAllocator: slab/free-list arena that recycles freed nodes and
+//                releases all of its slabs at once on destruction
+//
+
+#ifndef NODE_ALLOCATOR_H_
+#define NODE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// HeapAllocator - allocate every node individually on the heap
+template <typename T>
+class HeapAllocator {
+ public:
+  // Allocate - construct a new @T from @args
+  template <typename... Args>
+  T* Allocate(Args&&... args) {
+    return new T{std::forward<Args>(args)...};
+  }
+
+  // Deallocate - destroy & free @p
+  void Deallocate(T *p) {
+    delete p;
+  }
+};
+
+// PoolAllocator - hand out nodes from contiguous slabs of kSlabSize nodes;
+//                 freed nodes go on a free list and are reused first
+template <typename T>
+class PoolAllocator {
+ public:
+  // Number of nodes carved out of each slab
+  static constexpr std::size_t kSlabSize = 1024;
+
+  PoolAllocator(void) = default;
+  PoolAllocator(const PoolAllocator&) = delete;
+  PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+  // ~PoolAllocator() - slabs are released in one shot
+  ~PoolAllocator(void) = default;
+
+  // Allocate - construct a new @T from @args in a recycled or fresh slot
+  template <typename... Args>
+  T* Allocate(Args&&... args) {
+    Slot *s;
+    // Reuse most recently freed slot if possible
+    if (free_list) {
+      s = free_list;
+      free_list = free_list->next;
+    // Otherwise carve next slot out of current slab
+    } else {
+      if (slab_used == kSlabSize) {
+        slabs.emplace_back(new Slot[kSlabSize]);
+        slab_used = 0;
+      }
+      s = &slabs.back()[slab_used++];
+    }
+    return new (&s->storage) T{std::forward<Args>(args)...};
+  }
+
+  // Deallocate - destroy @p and push its slot onto the free list
+  void Deallocate(T *p) {
+    p->~T();
+    Slot *s = reinterpret_cast<Slot*>(p);
+    s->next = free_list;
+    free_list = s;
+  }
+
+ private:
+  // Slot - storage for one @T, or a free list link once released
+  union Slot {
+    Slot *next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  std::vector<std::unique_ptr<Slot[]>> slabs;
+  Slot *free_list = nullptr;
+  std::size_t slab_used = kSlabSize;
+};
+
+template <typename T>
+constexpr std::size_t PoolAllocator<T>::kSlabSize;
+
+#endif  // NODE_ALLOCATOR_H_
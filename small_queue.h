@@ -0,0 +1,221 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// small_queue.h - FIFO value list with inline storage for the first N
+// values, used by the Multimap nodes to hold duplicate-key values.
+// Values live in a ring buffer that stays inside the object until an
+// (N+1)th value spills it to the heap, doubling capacity from then on.
+// Public API: size, empty, front, operator[], push_back, pop_front,
+//             erase, clear, begin, end
+//
+
+#ifndef SMALL_QUEUE_H_
+#define SMALL_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename T, std::size_t N>
+class SmallQueue {
+  static_assert(N > 0, "SmallQueue needs at least one inline slot");
+
+ public:
+  // const_iterator - walk values front to back
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    const_iterator(const SmallQueue *q, uint32_t i) : queue(q), index(i) {}
+    reference operator*() const { return (*queue)[index]; }
+    pointer operator->() const { return &(*queue)[index]; }
+    const_iterator& operator++() { index++; return *this; }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      index++;
+      return old;
+    }
+    bool operator==(const const_iterator &o) const {
+      return index == o.index;
+    }
+    bool operator!=(const const_iterator &o) const {
+      return index != o.index;
+    }
+
+   private:
+    const SmallQueue *queue;
+    uint32_t index;
+  };
+
+  SmallQueue(void) = default;
+  SmallQueue(const SmallQueue&) = delete;
+  SmallQueue& operator=(const SmallQueue&) = delete;
+
+  // SmallQueue(&&) - steal heap buffer or move inline values one by one
+  SmallQueue(SmallQueue &&o) {
+    Steal(o);
+  }
+
+  SmallQueue& operator=(SmallQueue &&o) {
+    if (this != &o) {
+      Release();
+      Steal(o);
+    }
+    return *this;
+  }
+
+  ~SmallQueue(void) {
+    Release();
+  }
+
+  // size - return # of values held
+  std::size_t size(void) const {
+    return count;
+  }
+
+  // empty - return true if no values held
+  bool empty(void) const {
+    return count == 0;
+  }
+
+  // front - return first (oldest) value
+  T& front(void) {
+    return Data()[head];
+  }
+  const T& front(void) const {
+    return Data()[head];
+  }
+
+  // operator[] - return @i-th value counting from the front
+  const T& operator[](std::size_t i) const {
+    return Data()[Slot(i)];
+  }
+
+  // push_back - append @value, spilling to the heap when full
+  void push_back(const T &value) {
+    if (count == cap)
+      Grow();
+    new (&Data()[Slot(count)]) T(value);
+    count++;
+  }
+  void push_back(T &&value) {
+    if (count == cap)
+      Grow();
+    new (&Data()[Slot(count)]) T(std::move(value));
+    count++;
+  }
+
+  // pop_front - drop first (oldest) value
+  void pop_front(void) {
+    Data()[head].~T();
+    if (++head == cap)
+      head = 0;
+    if (--count == 0)
+      head = 0;
+  }
+
+  // erase - drop @i-th value, shifting later values forward to keep
+  //         their order
+  void erase(std::size_t i) {
+    T *data = Data();
+    for (; i + 1 < count; i++)
+      data[Slot(i)] = std::move(data[Slot(i + 1)]);
+    data[Slot(count - 1)].~T();
+    if (--count == 0)
+      head = 0;
+  }
+
+  // clear - drop all values, keeping any heap buffer for reuse
+  void clear(void) {
+    while (count)
+      pop_front();
+  }
+
+  const_iterator begin(void) const {
+    return const_iterator(this, 0);
+  }
+  const_iterator end(void) const {
+    return const_iterator(this, count);
+  }
+
+ private:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+  uint32_t head = 0;
+  uint32_t count = 0;
+  uint32_t cap = N;
+  // Inline slots while cap == N, heap buffer once spilled
+  union {
+    Storage small[N];
+    T *heap;
+  };
+
+  // Data - return start of current buffer
+  T* Data(void) {
+    return cap == N ? reinterpret_cast<T*>(small) : heap;
+  }
+  const T* Data(void) const {
+    return cap == N ? reinterpret_cast<const T*>(small) : heap;
+  }
+
+  // Slot - map logical index @i onto the ring buffer
+  uint32_t Slot(std::size_t i) const {
+    std::size_t s = head + i;
+    return static_cast<uint32_t>(s >= cap ? s - cap : s);
+  }
+
+  // Grow - double capacity, moving values to the front of a heap buffer
+  void Grow(void) {
+    uint32_t new_cap = cap * 2;
+    T *buf = static_cast<T*>(::operator new(new_cap * sizeof(T)));
+    T *old = Data();
+    for (uint32_t i = 0; i < count; i++) {
+      new (&buf[i]) T(std::move(old[Slot(i)]));
+      old[Slot(i)].~T();
+    }
+    if (cap != N)
+      ::operator delete(heap);
+    heap = buf;
+    cap = new_cap;
+    head = 0;
+  }
+
+  // Release - destroy values & free heap buffer
+  void Release(void) {
+    clear();
+    if (cap != N)
+      ::operator delete(heap);
+    cap = N;
+  }
+
+  // Steal - take over values of @o, leaving it empty
+  void Steal(SmallQueue &o) {
+    if (o.cap != N) {
+      heap = o.heap;
+      cap = o.cap;
+      head = o.head;
+      count = o.count;
+      o.cap = N;
+    } else {
+      cap = N;
+      head = 0;
+      count = 0;
+      for (uint32_t i = 0; i < o.count; i++)
+        push_back(std::move(o.Data()[o.Slot(i)]));
+      o.clear();
+    }
+    o.head = 0;
+    o.count = 0;
+  }
+};
+
+#endif  // SMALL_QUEUE_H_
@@ -0,0 +1,471 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// smp_sched.h - Multi-CPU simulation of the CFS Linux Kernel Scheduler.
+// RunQueue: one CPU's timeline, min_vruntime & running task
+// LoadTree: tournament tree over a count per CPU, finding the best CPU
+//           & the next one to visit without scanning them all
+// SmpScheduler: places each arrival on the least loaded CPU & migrates
+//               tasks between runqueues, periodically & whenever a CPU
+//               goes idle, carrying vruntime over relative to each
+//               queue's min_vruntime; tasks in groups or with sleeps
+//               are rejected
+//
+
+#ifndef SMP_SCHED_H_
+#define SMP_SCHED_H_
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cfs_sched.h"
+#include "multimap.h"
+
+// RunQueue - class to represent the runqueue of one CPU
+class RunQueue {
+ public:
+    // RunQueue() - runqueue of tasks stored in @tasks, shared by all CPUs
+    explicit RunQueue(TaskPool& tasks) : pool(tasks) {}
+    RunQueue(const RunQueue&) = delete;
+    RunQueue& operator=(const RunQueue&) = delete;
+
+    // admit - add newly arrived @task at the queue's min_vruntime
+    void admit(const Task& task) {
+      TaskHandle h = pool.Admit(task.getID(), task.getDuration(),
+                                task.getNice(), min_vruntime);
+      timeline.Insert(VRuntime(min_vruntime), h);
+    }
+
+    // moveNextTask - check if currently running task should transfer to next
+    void moveNextTask(void) {
+      if (waiting() && !current_task.isNull() &&
+          vruntimeBefore(min_vruntime, pool.getvRuntime(current_task))) {
+        timeline.Insert(VRuntime(pool.getvRuntime(current_task)),
+                        current_task);
+        current_task = TaskHandle();
+      }
+    }
+
+    // getNextTask - if current task stopped, get next schedulable task
+    void getNextTask(void) {
+      if (current_task.isNull() && waiting()) {
+        VRuntime next_min;
+        current_task = pool.Check(timeline.PopMin(&next_min));
+        if (waiting())
+          min_vruntime = next_min.get();
+      }
+    }
+
+    // runTick - current task runs for one tick; return true if it
+    //           completed & was purged
+    bool runTick(void) {
+      if (current_task.isNull())
+        return false;
+      pool.incRunTimes(current_task);
+      busy_ticks++;
+      if (!pool.isComplete(current_task))
+        return false;
+      pool.Release(current_task);
+      current_task = TaskHandle();
+      return true;
+    }
+
+    // runStretch - current task runs for @ticks ticks, fewer than it has
+    //              left, in one step
+    void runStretch(uint64_t ticks) {
+      pool.incRunTimes(current_task, ticks);
+      busy_ticks += ticks;
+    }
+
+    // ticksLeft - return # of ticks current task has left to run
+    uint64_t ticksLeft(void) const {
+      return pool.getRemaining(current_task);
+    }
+
+    // busy - return true if a task is running on this CPU
+    bool busy(void) const {
+      return !current_task.isNull();
+    }
+
+    // detachTask - remove the waiting task with the largest vruntime,
+    //              the one this queue would run last, leaving its
+    //              vruntime relative to the queue's min_vruntime
+    TaskHandle detachTask(void) {
+      VRuntime key = timeline.Max();
+      TaskHandle task = pool.Check(timeline.Get(key));
+      timeline.Remove(key);
+      int64_t lag = static_cast<int64_t>(pool.getvRuntime(task) -
+                                         min_vruntime);
+      pool.setvRuntime(task, lag > 0 ? lag : 0);
+      migrations_out++;
+      return task;
+    }
+
+    // attachTask - add a task detached from another queue, keeping its
+    //              lag behind min_vruntime
+    void attachTask(TaskHandle task) {
+      pool.setvRuntime(task, pool.getvRuntime(task) + min_vruntime);
+      timeline.Insert(VRuntime(pool.getvRuntime(task)), task);
+      migrations_in++;
+    }
+
+    // waiting - return # of tasks waiting in the timeline
+    unsigned int waiting(void) {
+      return timeline.Size();
+    }
+
+    // running - return total # of tasks on this CPU
+    unsigned int running(void) {
+      return waiting() + (current_task.isNull() ? 0 : 1);
+    }
+
+    // getBusyTicks - return # of ticks a task ran on this CPU
+    uint64_t getBusyTicks(void) const {
+      return busy_ticks;
+    }
+
+    // getMigrationsIn - return # of tasks migrated onto this CPU
+    uint64_t getMigrationsIn(void) const {
+      return migrations_in;
+    }
+
+    // getMigrationsOut - return # of tasks migrated off this CPU
+    uint64_t getMigrationsOut(void) const {
+      return migrations_out;
+    }
+
+ private:
+    // Run state of the tasks on every CPU
+    TaskPool& pool;
+    // Per-CPU min_vruntime
+    uint64_t min_vruntime = kInitialVRuntime;
+    // RB-tree multimap to hold timeline of tasks, nodes recycled by a pool
+    Multimap<VRuntime, TaskHandle, PoolAllocator> timeline;
+    // Currently running task, null if none
+    TaskHandle current_task;
+    // Statistics reported in the summary
+    uint64_t busy_ticks = 0;
+    uint64_t migrations_in = 0;
+    uint64_t migrations_out = 0;
+};
+
+// LoadTree - count per CPU kept in a tournament tree, each node holding
+//            the CPU with the best count below it, lowest index on ties,
+//            so the best CPU is read in O(1) & a count is updated, or the
+//            next CPU with a count as good as a bound found, in
+//            O(log CPUs); @Better orders counts, best first
+template <typename Better>
+class LoadTree {
+ public:
+    // LoadTree() - @n CPUs, padded to a power of two with @worst counts
+    LoadTree(std::size_t n, unsigned int worst) : leaves(1) {
+      while (leaves < n)
+        leaves *= 2;
+      counts.assign(leaves, worst);
+      for (std::size_t i = 0; i < n; i++)
+        counts[i] = 0;
+      winners.resize(2 * leaves);
+      for (std::size_t i = 0; i < leaves; i++)
+        winners[leaves + i] = i;
+      for (std::size_t node = leaves - 1; node > 0; node--)
+        winners[node] = Pick(winners[2 * node], winners[2 * node + 1]);
+    }
+
+    // Set - change count of CPU @i to @count
+    void Set(std::size_t i, unsigned int count) {
+      if (counts[i] == count)
+        return;
+      counts[i] = count;
+      for (std::size_t node = (leaves + i) / 2; node > 0; node /= 2)
+        winners[node] = Pick(winners[2 * node], winners[2 * node + 1]);
+    }
+
+    // Best - return CPU with the best count
+    std::size_t Best(void) const {
+      return winners[1];
+    }
+
+    // FindFrom - return first CPU from @i on whose count is as good as
+    //            @bound, or the # of leaves if none
+    std::size_t FindFrom(std::size_t i, unsigned int bound) const {
+      return Find(1, 0, leaves, i, bound);
+    }
+
+ private:
+    std::size_t leaves;
+    std::vector<unsigned int> counts;
+    std::vector<std::size_t> winners;
+
+    // Pick - return whichever of CPUs @a < @b has the better count
+    std::size_t Pick(std::size_t a, std::size_t b) const {
+      return Better()(counts[b], counts[a]) ? b : a;
+    }
+
+    // Find - search subtree @node, covering CPUs [@lo, @lo + @width),
+    //        skipping CPUs below @i & subtrees whose best misses @bound
+    std::size_t Find(std::size_t node, std::size_t lo, std::size_t width,
+                     std::size_t i, unsigned int bound) const {
+      if (lo + width <= i || Better()(bound, counts[winners[node]]))
+        return leaves;
+      if (width == 1)
+        return lo;
+      std::size_t found = Find(2 * node, lo, width / 2, i, bound);
+      return found < leaves ? found :
+        Find(2 * node + 1, lo + width / 2, width / 2, i, bound);
+    }
+};
+
+// SmpScheduler - class to represent CFS over a set of CPUs
+class SmpScheduler {
+ public:
+    // Ticks between periodic load balancing passes
+    static const unsigned int kBalanceInterval = 4;
+
+    // SmpScheduler() - admit tasks from @tasks onto @n_cpus runqueues;
+    //                 throws if @tasks names groups or bursts
+    SmpScheduler(TaskSource& tasks, unsigned int n_cpus) :
+        arrivals(tasks), loads(n_cpus, UINT_MAX), waits(n_cpus, 0),
+        busy_slot(n_cpus, SIZE_MAX) {
+      const TaskGroups *groups = tasks.Groups();
+      const TaskBursts *bursts = tasks.Bursts();
+      if ((groups && groups->Size() > 1) || (bursts && bursts->Size()))
+        unsupported();
+      cpus.reserve(n_cpus);
+      for (unsigned int i = 0; i < n_cpus; i++)
+        cpus.emplace_back(new RunQueue(pool));
+    }
+
+    // appendTimeline - place tasks launched at tick value on the CPU
+    //                  running the fewest tasks
+    void appendTimeline(void) {
+      uint64_t start;
+      while (arrivals.NextStart(&start) && start <= tick_counter) {
+        Task task = arrivals.Pop();
+        // A stream names groups & bursts only as its tasks arrive
+        if (task.getGroup() != TaskGroups::kRoot ||
+            task.getBursts() != TaskBursts::kNone)
+          unsupported();
+        std::size_t i = leastLoaded();
+        cpus[i]->admit(task);
+        update(i);
+        live_tasks++;
+      }
+    }
+
+    // balance - every kBalanceInterval ticks, move tasks from the most
+    //           to the least loaded CPU until they differ by at most one
+    void balance(void) {
+      if (tick_counter % kBalanceInterval)
+        return;
+      for (;;) {
+        std::size_t src = mostWaiting();
+        std::size_t dst = leastLoaded();
+        if (!cpus[src]->waiting() ||
+            cpus[src]->running() <= cpus[dst]->running() + 1)
+          break;
+        cpus[dst]->attachTask(cpus[src]->detachTask());
+        update(src);
+        update(dst);
+      }
+    }
+
+    // schedule - pick the task each CPU runs this tick, pulling a waiting
+    //            task from the busiest CPU onto any CPU left idle
+    void schedule(void) {
+      // Only look for idle CPUs while one has tasks to spare
+      bool can_pull = true;
+      // Visit in order only the CPUs with tasks waiting, which may pick
+      // or switch, & the idle ones; the rest keep running their task
+      for (std::size_t i = nextToSchedule(0, can_pull); i < cpus.size();
+           i = nextToSchedule(i + 1, can_pull)) {
+        RunQueue& cpu = *cpus[i];
+        cpu.moveNextTask();
+        cpu.getNextTask();
+        if (!cpu.running() && can_pull) {
+          std::size_t src = mostWaiting();
+          if (cpus[src]->running() < 2) {
+            can_pull = false;
+          } else {
+            cpu.attachTask(cpus[src]->detachTask());
+            cpu.getNextTask();
+            update(src);
+          }
+        }
+        update(i);
+      }
+    }
+
+    // runTick - every busy CPU's current task runs for one tick
+    void runTick(void) {
+      // Walk backward, a CPU going idle swaps a visited one into its place
+      for (std::size_t n = busy_cpus.size(); n-- > 0; ) {
+        std::size_t i = busy_cpus[n];
+        if (cpus[i]->runTick()) {
+          live_tasks--;
+          update(i);
+        }
+      }
+    }
+
+    // incrementTick - move to the next tick; while no CPU has tasks
+    //                 waiting, only a completion or arrival changes what
+    //                 runs, so jump to the tick before the first of them,
+    //                 running each busy CPU's task up to it in one step
+    void incrementTick(void) {
+      tick_counter++;
+      if (cpus[mostWaiting()]->waiting())
+        return;
+      uint64_t ticks = UINT64_MAX;
+      for (std::size_t i : busy_cpus)
+        ticks = std::min(ticks, cpus[i]->ticksLeft() - 1);
+      uint64_t start;
+      if (arrivals.NextStart(&start))
+        ticks = std::min(ticks, start > tick_counter ?
+                                start - tick_counter : 0);
+      if (ticks == UINT64_MAX || !ticks)
+        return;
+      for (std::size_t i : busy_cpus)
+        cpus[i]->runStretch(ticks);
+      tick_counter += ticks;
+    }
+
+    // done - return true if all tasks have arrived & completed
+    bool done(void) {
+      uint64_t start;
+      return !live_tasks && !arrivals.NextStart(&start);
+    }
+
+    // printSummary - print utilization & migrations of each CPU
+    void printSummary(std::ostream& os) {
+      uint64_t busy = 0;
+      uint64_t migrations = 0;
+      os << "ticks: " << tick_counter << '\n';
+      for (std::size_t i = 0; i < cpus.size(); i++) {
+        busy += cpus[i]->getBusyTicks();
+        migrations += cpus[i]->getMigrationsIn();
+        os << "cpu " << i << ": busy " << cpus[i]->getBusyTicks() << " (" <<
+          percent(cpus[i]->getBusyTicks(), tick_counter) <<
+          "%) migrations in " << cpus[i]->getMigrationsIn() << " out " <<
+          cpus[i]->getMigrationsOut() << '\n';
+      }
+      os << "total: busy " << busy << " (" <<
+        percent(busy, static_cast<uint64_t>(tick_counter) * cpus.size()) <<
+        "%) migrations " << migrations << std::endl;
+    }
+
+    // getCPU - return runqueue of CPU @i
+    const RunQueue& getCPU(std::size_t i) const {
+      return *cpus[i];
+    }
+
+    // getTicks - return # of ticks simulated
+    uint64_t getTicks(void) const {
+      return tick_counter;
+    }
+
+ private:
+    // Run state of every task, shared by the runqueues
+    TaskPool pool;
+    // One runqueue per CPU
+    std::vector<std::unique_ptr<RunQueue>> cpus;
+    // Tasks yet to arrive
+    TaskSource& arrivals;
+    // Tick counter
+    uint64_t tick_counter = 0;
+    // # of tasks admitted & not yet completed
+    uint64_t live_tasks = 0;
+    // # of tasks on each CPU, fewest first, & of tasks waiting, most first
+    LoadTree<std::less<unsigned int>> loads;
+    LoadTree<std::greater<unsigned int>> waits;
+    // CPUs running a task, in no order, & each CPU's place among them,
+    // SIZE_MAX if idle
+    std::vector<std::size_t> busy_cpus;
+    std::vector<std::size_t> busy_slot;
+
+    // leastLoaded - return index of CPU running the fewest tasks, lowest
+    //               index first
+    std::size_t leastLoaded(void) {
+      return loads.Best();
+    }
+
+    // mostWaiting - return index of CPU with the most waiting tasks,
+    //               lowest index first
+    std::size_t mostWaiting(void) {
+      return waits.Best();
+    }
+
+    // nextToSchedule - return first CPU from @i on with tasks waiting, or
+    //                  idle if @idle, the # of CPUs if none
+    std::size_t nextToSchedule(std::size_t i, bool idle) {
+      std::size_t next = std::min(waits.FindFrom(i, 1), cpus.size());
+      return idle ? std::min(next, loads.FindFrom(i, 0)) : next;
+    }
+
+    // update - record the tasks of CPU @i after they changed
+    void update(std::size_t i) {
+      loads.Set(i, cpus[i]->running());
+      waits.Set(i, cpus[i]->waiting());
+      bool listed = busy_slot[i] != SIZE_MAX;
+      if (cpus[i]->busy() == listed)
+        return;
+      if (listed) {
+        std::size_t last = busy_cpus.back();
+        busy_cpus[busy_slot[i]] = last;
+        busy_slot[last] = busy_slot[i];
+        busy_cpus.pop_back();
+        busy_slot[i] = SIZE_MAX;
+      } else {
+        busy_slot[i] = busy_cpus.size();
+        busy_cpus.push_back(i);
+      }
+    }
+
+    // unsupported - throw for a task the runqueues cannot simulate
+    static void unsupported(void) {
+      throw std::invalid_argument("task groups & sleeps need a single CPU,"
+                                  " drop --cpus");
+    }
+
+    // percent - return @part as a percentage of @whole, formatted to
+    //           one decimal place
+    static std::string percent(uint64_t part, uint64_t whole) {
+      std::ostringstream os;
+      os << std::fixed << std::setprecision(1) <<
+        (whole ? 100.0 * part / whole : 0.0);
+      return os.str();
+    }
+};
+
+// runSMP - run the CFS algorithm on tasks from @tasks over @n_cpus CPUs,
+//          printing the per-CPU summary to @os
+inline void runSMP(TaskSource& tasks, unsigned int n_cpus,
+                   std::ostream& os = std::cout) {
+  SmpScheduler smp(tasks, n_cpus);
+
+  do {
+    // 1) Place tasks launched at tick value
+    smp.appendTimeline();
+    // 2) Even out the runqueues on balancing ticks
+    smp.balance();
+    // 3) Pick each CPU's task, pulling work onto idle CPUs
+    smp.schedule();
+    // 4) Current tasks run for one tick, completed tasks are purged
+    smp.runTick();
+    // 5) Move to the next tick
+    smp.incrementTick();
+  } while (!smp.done());
+
+  smp.printSummary(os);
+}
+
+#endif  // SMP_SCHED_H_
@@ -0,0 +1,217 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// status_sink.h - Destinations for the scheduler's per-tick status lines
+// StatusSink: interface receiving one report per stretch of ticks
+// TextSink: "<tick> [<#tasks>]: <ID>" per tick, buffered with no flushing
+//           until the buffer fills or the run ends
+// RunLengthSink: one "<first>-<last> [<#tasks>]: <ID>" line per stretch
+//                where the same task runs with the same # of tasks
+// NullSink: discards every report, for timing the scheduler alone
+//
+
+#ifndef STATUS_SINK_H_
+#define STATUS_SINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// StatusSink - receives scheduling status over a stretch of ticks
+class StatusSink {
+ public:
+    virtual ~StatusSink(void) = default;
+
+    // Report - task @id ('_' if idle) ran on ticks @first..@last with
+    //          @running tasks in the system, completing on @last if
+    //          @complete
+    virtual void Report(uint64_t first, uint64_t last,
+                        unsigned int running, char id, bool complete) = 0;
+
+    // Flush - write out anything still buffered
+    virtual void Flush(void) = 0;
+
+    // Drain - write out finished lines only, so a pending run can still
+    //         be extended by later reports
+    virtual void Drain(void) = 0;
+};
+
+// BufferedWriter - format status fields into a fixed-size buffer and hand
+//                  it to the stream in large writes
+class BufferedWriter {
+ public:
+    // Size of the buffer handed to the stream per write
+    static const std::size_t kBufferSize = 1 << 16;
+
+    explicit BufferedWriter(std::ostream& out) : os(out), buffer(kBufferSize),
+        used(0) {}
+
+    ~BufferedWriter(void) {
+      Flush();
+    }
+
+    // Reserve - make room for @n more characters
+    void Reserve(std::size_t n) {
+      if (used + n > buffer.size())
+        Flush();
+    }
+
+    // Put - append a single character
+    void Put(char c) {
+      buffer[used++] = c;
+    }
+
+    // PutUInt - append decimal digits of @value
+    void PutUInt(uint64_t value) {
+      char digits[20];
+      int n = 0;
+      do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value);
+      while (n)
+        buffer[used++] = digits[--n];
+    }
+
+    // PutLine - append "<first>[-<last>] [<running>]: <id>[*]\n"
+    void PutLine(uint64_t first, uint64_t last, unsigned int running,
+                 char id, bool complete) {
+      // 3 numbers of at most 20 digits plus punctuation
+      Reserve(72);
+      PutUInt(first);
+      if (last != first) {
+        Put('-');
+        PutUInt(last);
+      }
+      Put(' ');
+      Put('[');
+      PutUInt(running);
+      Put(']');
+      Put(':');
+      Put(' ');
+      Put(id);
+      if (complete)
+        Put('*');
+      Put('\n');
+    }
+
+    // Flush - write buffered characters to the stream
+    void Flush(void) {
+      if (used) {
+        os.write(buffer.data(), used);
+        used = 0;
+      }
+      os.flush();
+    }
+
+ private:
+    std::ostream& os;
+    std::vector<char> buffer;
+    std::size_t used;
+};
+
+// TextSink - one line per tick in the original format
+class TextSink : public StatusSink {
+ public:
+    explicit TextSink(std::ostream& out = std::cout) : writer(out) {}
+
+    void Report(uint64_t first, uint64_t last, unsigned int running,
+                char id, bool complete) override {
+      // Expand the stretch, completion only shows on its last tick
+      for (uint64_t tick = first; tick != last; tick++)
+        writer.PutLine(tick, tick, running, id, false);
+      writer.PutLine(last, last, running, id, complete);
+    }
+
+    void Flush(void) override {
+      writer.Flush();
+    }
+
+    void Drain(void) override {
+      writer.Flush();
+    }
+
+ private:
+    BufferedWriter writer;
+};
+
+// RunLengthSink - merge consecutive ticks with the same task & # of tasks
+class RunLengthSink : public StatusSink {
+ public:
+    explicit RunLengthSink(std::ostream& out = std::cout) : writer(out) {}
+
+    ~RunLengthSink(void) {
+      Flush();
+    }
+
+    void Report(uint64_t first, uint64_t last, unsigned int running,
+                char id, bool complete) override {
+      // Extend the pending run if nothing changed
+      if (pending && run_id == id && run_running == running &&
+          run_last + 1 == first) {
+        run_last = last;
+      } else {
+        EmitRun();
+        pending = true;
+        run_first = first;
+        run_last = last;
+        run_running = running;
+        run_id = id;
+      }
+      // A completed task closes its run
+      if (complete) {
+        writer.PutLine(run_first, run_last, run_running, run_id, true);
+        pending = false;
+      }
+    }
+
+    void Flush(void) override {
+      EmitRun();
+      writer.Flush();
+    }
+
+    void Drain(void) override {
+      writer.Flush();
+    }
+
+ private:
+    BufferedWriter writer;
+    // Run waiting to be extended or written
+    bool pending = false;
+    uint64_t run_first = 0;
+    uint64_t run_last = 0;
+    unsigned int run_running = 0;
+    char run_id = '_';
+
+    // EmitRun - write out the pending run, if any
+    void EmitRun(void) {
+      if (pending)
+        writer.PutLine(run_first, run_last, run_running, run_id, false);
+      pending = false;
+    }
+};
+
+// NullSink - drop all status, keeping only the # of reports
+class NullSink : public StatusSink {
+ public:
+    void Report(uint64_t, uint64_t, unsigned int, char, bool) override {
+      reports++;
+    }
+
+    void Flush(void) override {}
+
+    void Drain(void) override {}
+
+    // getReports - return # of reports received
+    uint64_t getReports(void) const {
+      return reports;
+    }
+
+ private:
+    uint64_t reports = 0;
+};
+
+#endif  // STATUS_SINK_H_
@@ -0,0 +1,60 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// task_bursts.h - Burst & sleep sequences of the tasks of a run.
+// TaskBursts: stores each "<burst>:<sleep>:<burst>..." duration as its
+//             ticks in one flat array, a task referring to its sequence
+//             by offset; offset 0 stands for a task that never sleeps
+//
+
+#ifndef TASK_BURSTS_H_
+#define TASK_BURSTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// TaskBursts - CPU bursts & the sleeps between them, task after task
+class TaskBursts {
+ public:
+    // Offset of tasks running their whole duration in one burst
+    static const uint64_t kNone = 0;
+
+    TaskBursts(void) : ticks{0} {}
+
+    // Intern - store the sequence at @text of @length chars & return its
+    //          offset; @text must be well formed, as TaskScanner checks
+    uint64_t Intern(const char *text, std::size_t length) {
+      uint64_t offset = ticks.size();
+      uint64_t value = 0;
+      for (std::size_t i = 0; i < length; i++) {
+        if (text[i] == ':') {
+          ticks.push_back(value);
+          value = 0;
+        } else {
+          value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+        }
+      }
+      ticks.push_back(value);
+      return offset;
+    }
+
+    // getTicks - return length of the burst or sleep at @offset: the
+    //            first burst of a sequence at its offset, followed by
+    //            each sleep & the burst after it
+    uint64_t getTicks(uint64_t offset) const {
+      return ticks[offset];
+    }
+
+    // Size - return # of bursts & sleeps stored
+    std::size_t Size(void) const {
+      return ticks.size() - 1;
+    }
+
+ private:
+    std::vector<uint64_t> ticks;
+};
+
+#endif  // TASK_BURSTS_H_
@@ -0,0 +1,78 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// task_groups.h - Names of the task groups of a run.
+// TaskGroups: interns group paths such as "/tenant/web" into dense ids,
+//             creating every ancestor on the way; id 0 is the root
+//             group "/", which holds tasks naming no group
+//
+
+#ifndef TASK_GROUPS_H_
+#define TASK_GROUPS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// TaskGroups - tree of task group paths
+class TaskGroups {
+ public:
+    // Id of the root group
+    static const uint32_t kRoot = 0;
+
+    TaskGroups(void) : paths{"/"}, parents{kRoot} {}
+
+    // Intern - return id of the group at @path of @length chars, adding
+    //          it & any missing ancestor; an empty path or "/" is the
+    //          root. @path must be well formed, as TaskScanner checks
+    uint32_t Intern(const char *path, std::size_t length) {
+      if (length <= 1)
+        return kRoot;
+      uint32_t group = kRoot;
+      // Look up each prefix ending before a '/' & the whole path
+      for (std::size_t end = 1; end <= length; end++) {
+        if (end < length && path[end] != '/')
+          continue;
+        std::string prefix(path, end);
+        auto it = ids.find(prefix);
+        if (it != ids.end()) {
+          group = it->second;
+          continue;
+        }
+        uint32_t parent = group;
+        group = static_cast<uint32_t>(paths.size());
+        paths.push_back(prefix);
+        parents.push_back(parent);
+        ids.emplace(prefix, group);
+      }
+      return group;
+    }
+
+    // Size - return # of groups, the root included
+    std::size_t Size(void) const {
+      return paths.size();
+    }
+
+    // getParent - return id of the parent of @group, the root its own
+    uint32_t getParent(uint32_t group) const {
+      return parents[group];
+    }
+
+    // getPath - return full path of @group
+    const std::string& getPath(uint32_t group) const {
+      return paths[group];
+    }
+
+ private:
+    // Path & parent of each group, by id
+    std::vector<std::string> paths;
+    std::vector<uint32_t> parents;
+    // Id of each path below the root
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+#endif  // TASK_GROUPS_H_
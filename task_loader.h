@@ -0,0 +1,430 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// task_loader.h - Zero-copy parsing of task files
+// MappedFile: read-only mmap of a whole file
+// TaskScanner: hand-written scanner turning "<id> <start> <duration>"
+//              lines, with an optional nice level & then an optional
+//              group path such as "/tenant/web", into TaskRecords,
+//              reporting line & column of any malformed record
+//              through TaskParseError; a duration of
+//              "<burst>:<sleep>:<burst>..." runs in CPU bursts with
+//              sleeps between them
+// StreamScanner: TaskScanner over a pipe, FIFO or other descriptor,
+//                read in chunks & parsed a line at a time
+//
+
+#ifndef TASK_LOADER_H_
+#define TASK_LOADER_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "nice_weights.h"
+
+// TaskRecord - fields of one task line
+struct TaskRecord {
+  char id;
+  uint64_t start_time;
+  // Total ticks of CPU time, summed over the bursts if any
+  uint64_t duration;
+  // Burst & sleep sequence within the scanned input, empty if the task
+  // runs its whole duration in one burst; valid as long as the group path
+  const char *bursts;
+  std::size_t bursts_length;
+  // Nice level, 0 if the line has no nice column
+  int nice;
+  // Group path within the scanned input, empty if the line names none;
+  // valid until the input is released or read past
+  const char *group;
+  std::size_t group_length;
+};
+
+// TaskParseError - malformed record at @line, @column (both from 1)
+class TaskParseError : public std::runtime_error {
+ public:
+    TaskParseError(std::size_t l, std::size_t c, const std::string& what) :
+        std::runtime_error(std::to_string(l) + ":" + std::to_string(c) +
+                           ": " + what),
+        line(l), column(c) {}
+
+    std::size_t getLine(void) const {
+      return line;
+    }
+
+    std::size_t getColumn(void) const {
+      return column;
+    }
+
+ private:
+    std::size_t line;
+    std::size_t column;
+};
+
+// MappedFile - map @file_name read-only for the lifetime of the object
+class MappedFile {
+ public:
+    explicit MappedFile(const char *file_name) {
+      int fd = open(file_name, O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error(std::string("cannot open file ") +
+                                 file_name);
+      struct stat st;
+      if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw std::runtime_error(std::string("cannot stat file ") +
+                                 file_name);
+      }
+      length = static_cast<std::size_t>(st.st_size);
+      // Empty files cannot be mapped, leave them as an empty range
+      if (length) {
+        void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+          close(fd);
+          throw std::runtime_error(std::string("cannot map file ") +
+                                   file_name);
+        }
+        data = static_cast<const char*>(p);
+        // Parsing runs front to back exactly once
+        madvise(p, length, MADV_SEQUENTIAL);
+      }
+      close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile(void) {
+      if (length)
+        munmap(const_cast<char*>(data), length);
+    }
+
+    const char* begin(void) const {
+      return data;
+    }
+
+    const char* end(void) const {
+      return data + length;
+    }
+
+    std::size_t size(void) const {
+      return length;
+    }
+
+ private:
+    const char *data = nullptr;
+    std::size_t length = 0;
+};
+
+// TaskScanner - parse task lines out of [begin, end) without copying
+class TaskScanner {
+ public:
+    TaskScanner(const char *begin, const char *end,
+                std::size_t first_line = 1) :
+        pos(begin), stop(end), line(first_line), line_start(begin) {}
+
+    // Next - parse the next record into @rec, skipping blank lines;
+    //        return false once input is exhausted
+    bool Next(TaskRecord& rec) {
+      // Skip blank lines
+      for (;;) {
+        SkipSpaces();
+        if (pos == stop)
+          return false;
+        if (*pos != '\n')
+          break;
+        NewLine();
+      }
+      // <id> is any single non-blank character
+      rec.id = *pos++;
+      if (pos != stop && !IsSpace(*pos) && *pos != '\n')
+        Fail("task id must be a single character");
+      rec.start_time = ScanUInt("start time");
+      ScanDuration(rec);
+      rec.nice = 0;
+      rec.group = nullptr;
+      rec.group_length = 0;
+      SkipSpaces();
+      if (pos != stop && *pos != '\n' && *pos != '/')
+        rec.nice = ScanNice();
+      SkipSpaces();
+      if (pos != stop && *pos == '/')
+        ScanGroup(rec);
+      // Nothing else may follow on the line
+      SkipSpaces();
+      if (pos != stop) {
+        if (*pos != '\n')
+          Fail(rec.group ? "unexpected field after group" :
+               "unexpected field after nice");
+        NewLine();
+      }
+      return true;
+    }
+
+    // getLine - return line number of the scanner's position
+    std::size_t getLine(void) const {
+      return line;
+    }
+
+ private:
+    const char *pos;
+    const char *stop;
+    std::size_t line;
+    const char *line_start;
+
+    static bool IsSpace(char c) {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    void SkipSpaces(void) {
+      while (pos != stop && IsSpace(*pos))
+        pos++;
+    }
+
+    void NewLine(void) {
+      pos++;
+      line++;
+      line_start = pos;
+    }
+
+    // Fail - throw error at current position
+    void Fail(const std::string& what) {
+      throw TaskParseError(line, pos - line_start + 1, what);
+    }
+
+    // ScanUInt - skip blanks & read a non-negative 64-bit decimal @field
+    uint64_t ScanUInt(const char *field) {
+      SkipSpaces();
+      uint64_t value = ScanDigits(field);
+      EndField(field);
+      return value;
+    }
+
+    // ScanDigits - read a non-negative 64-bit decimal @field
+    uint64_t ScanDigits(const char *field) {
+      if (pos == stop || *pos < '0' || *pos > '9')
+        Fail(std::string("expected ") + field);
+      const char *first = pos;
+      const uint64_t max = std::numeric_limits<uint64_t>::max();
+      uint64_t value = 0;
+      while (pos != stop && *pos >= '0' && *pos <= '9') {
+        unsigned int digit = static_cast<unsigned int>(*pos - '0');
+        if (value > (max - digit) / 10) {
+          pos = first;
+          Fail(std::string(field) + " out of range");
+        }
+        value = value * 10 + digit;
+        pos++;
+      }
+      return value;
+    }
+
+    // EndField - fail unless @field ends at a blank or the end of line
+    void EndField(const char *field) {
+      if (pos != stop && !IsSpace(*pos) && *pos != '\n')
+        Fail(std::string("invalid character in ") + field);
+    }
+
+    // ScanDuration - read the duration into @rec: total ticks, or
+    //                positive bursts & sleeps "<burst>:<sleep>:<burst>..."
+    //                summed over the bursts
+    void ScanDuration(TaskRecord& rec) {
+      SkipSpaces();
+      const char *first = pos;
+      rec.duration = ScanDigits("duration");
+      rec.bursts = nullptr;
+      rec.bursts_length = 0;
+      if (pos == stop || *pos != ':') {
+        EndField("duration");
+        return;
+      }
+      const uint64_t max = std::numeric_limits<uint64_t>::max();
+      const char *burst = first;
+      uint64_t ticks = rec.duration;
+      for (;;) {
+        if (!ticks) {
+          pos = burst;
+          Fail("empty burst");
+        }
+        if (pos == stop || *pos != ':')
+          break;
+        pos++;
+        const char *sleep = pos;
+        if (!ScanDigits("sleep")) {
+          pos = sleep;
+          Fail("empty sleep");
+        }
+        if (pos == stop || *pos != ':')
+          Fail("expected burst after sleep");
+        pos++;
+        burst = pos;
+        ticks = ScanDigits("burst");
+        if (ticks > max - rec.duration) {
+          pos = burst;
+          Fail("duration out of range");
+        }
+        rec.duration += ticks;
+      }
+      EndField("duration");
+      rec.bursts = first;
+      rec.bursts_length = static_cast<std::size_t>(pos - first);
+    }
+
+    // ScanNice - read a signed decimal nice level
+    int ScanNice(void) {
+      const char *first = pos;
+      bool negative = *pos == '-';
+      if (*pos == '-' || *pos == '+')
+        pos++;
+      if (pos == stop || *pos < '0' || *pos > '9')
+        Fail("invalid character in nice");
+      int value = 0;
+      while (pos != stop && *pos >= '0' && *pos <= '9') {
+        value = value * 10 + (*pos - '0');
+        if (value > -kMinNice) {
+          pos = first;
+          Fail("nice out of range");
+        }
+        pos++;
+      }
+      if (pos != stop && !IsSpace(*pos) && *pos != '\n')
+        Fail("invalid character in nice");
+      if (negative)
+        value = -value;
+      if (value > kMaxNice) {
+        pos = first;
+        Fail("nice out of range");
+      }
+      return value;
+    }
+
+    // ScanGroup - read a group path into @rec: "/" alone, or names of
+    //             non-blank chars each after one '/'
+    void ScanGroup(TaskRecord& rec) {
+      rec.group = pos;
+      while (pos != stop && !IsSpace(*pos) && *pos != '\n') {
+        // A '/' must start a name, unless it is the whole path
+        if (*pos == '/' && pos != rec.group &&
+            (pos[-1] == '/' || pos + 1 == stop || IsSpace(pos[1]) ||
+             pos[1] == '\n'))
+          Fail("empty group name");
+        pos++;
+      }
+      rec.group_length = static_cast<std::size_t>(pos - rec.group);
+    }
+};
+
+// StreamScanner - parse task lines from descriptor @fd as they arrive,
+//                 holding only the unparsed tail of the input in memory
+class StreamScanner {
+ public:
+    // Size of each read from the descriptor
+    static const std::size_t kChunkSize = 1 << 16;
+
+    // StreamScanner() - @stall is called before any read that would block
+    explicit StreamScanner(int in_fd,
+                           std::function<void(void)> stall = nullptr) :
+        fd(in_fd), buffer(kChunkSize), on_stall(stall) {}
+
+    StreamScanner(const StreamScanner&) = delete;
+    StreamScanner& operator=(const StreamScanner&) = delete;
+
+    // Next - parse the next record into @rec, skipping blank lines;
+    //        return false once the descriptor reaches end of file
+    bool Next(TaskRecord& rec) {
+      for (;;) {
+        const char *first = buffer.data() + pos;
+        const char *last = buffer.data() + filled;
+        const void *nl = std::memchr(first, '\n', last - first);
+        // Only hand whole lines to the scanner until input ends
+        if (!nl && !eof) {
+          Fill();
+          continue;
+        }
+        if (first == last)
+          return false;
+        const char *stop = nl ? static_cast<const char*>(nl) + 1 : last;
+        TaskScanner scanner(first, stop, line);
+        bool found = scanner.Next(rec);
+        pos += stop - first;
+        record_line = line++;
+        if (found)
+          return true;
+      }
+    }
+
+    // getRecordLine - return line number of the last record parsed
+    std::size_t getRecordLine(void) const {
+      return record_line;
+    }
+
+ private:
+    int fd;
+    std::vector<char> buffer;
+    std::function<void(void)> on_stall;
+    // Unparsed input is buffer[pos, filled)
+    std::size_t pos = 0;
+    std::size_t filled = 0;
+    std::size_t line = 1;
+    std::size_t record_line = 0;
+    bool eof = false;
+
+    // Fill - read more input after the unparsed tail
+    void Fill(void) {
+      // Slide the partial line to the front, growing only for lines
+      // longer than the buffer
+      std::memmove(buffer.data(), buffer.data() + pos, filled - pos);
+      filled -= pos;
+      pos = 0;
+      if (filled == buffer.size())
+        buffer.resize(buffer.size() * 2);
+
+      // Let the caller catch up before waiting on the writer
+      if (on_stall) {
+        struct pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, 0) == 0)
+          on_stall();
+      }
+
+      ssize_t n;
+      do {
+        n = read(fd, buffer.data() + filled, buffer.size() - filled);
+      } while (n < 0 && errno == EINTR);
+      if (n < 0)
+        throw std::runtime_error("cannot read task stream");
+      if (n == 0)
+        eof = true;
+      filled += static_cast<std::size_t>(n);
+    }
+};
+
+// countLines - return # of newline-terminated or trailing lines in range
+inline std::size_t countLines(const char *begin, const char *end) {
+  std::size_t lines = 0;
+  const char *p = begin;
+  while (p != end) {
+    const void *nl = std::memchr(p, '\n', end - p);
+    lines++;
+    if (!nl)
+      break;
+    p = static_cast<const char*>(nl) + 1;
+  }
+  return lines;
+}
+
+#endif  // TASK_LOADER_H_
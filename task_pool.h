@@ -0,0 +1,356 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// task_pool.h - Contiguous storage for the run state of admitted tasks.
+// TaskHandle: 32-bit reference to a pool slot, a 24-bit slot index under
+//             an 8-bit generation that changes whenever the slot is freed;
+//             a slot that used up its generations is retired, so a stale
+//             handle never matches again
+// TaskPool: structure of arrays holding each field the scheduler touches
+//           per tick in its own array, slots recycled on completion &
+//           stale handles rejected; each slot also holds the links that
+//           keep its task on an intrusive timeline, or in a timer wheel
+//           while it sleeps. The entity of a task group, which runs for
+//           its tasks, takes a slot with no id
+//
+
+#ifndef TASK_POOL_H_
+#define TASK_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "intrusive_tree.h"
+#include "nice_weights.h"
+#include "timer_wheel.h"
+
+// TaskHandle - generational reference to a task in a TaskPool
+class TaskHandle {
+ public:
+    // TaskHandle() - null handle, never valid in any pool
+    TaskHandle(void) : value(0) {}
+
+    // isNull - return true for the null handle
+    bool isNull(void) const {
+      return value == 0;
+    }
+
+    friend bool operator==(const TaskHandle& a, const TaskHandle& b) {
+      return a.value == b.value;
+    }
+
+    friend bool operator!=(const TaskHandle& a, const TaskHandle& b) {
+      return a.value != b.value;
+    }
+
+ private:
+    friend class TaskPool;
+
+    explicit TaskHandle(uint32_t v) : value(v) {}
+
+    uint32_t value;
+};
+
+// TaskPool - run state of every task in the system
+class TaskPool {
+ public:
+    // Bits of a handle holding the slot index, the rest hold generation
+    static const unsigned int kIndexBits = 24;
+    // Most tasks the pool can hold at once
+    static const uint32_t kMaxTasks = uint32_t(1) << kIndexBits;
+    // Id of freed slots & of group entities
+    static const char kNoID = '\0';
+
+    // TaskPool() - reserve room for @capacity tasks up front
+    explicit TaskPool(std::size_t capacity = 0) {
+      vruntime.reserve(capacity);
+      runtime.reserve(capacity);
+      duration.reserve(capacity);
+      burst_end.reserve(capacity);
+      vruntime_step.reserve(capacity);
+      ids.reserve(capacity);
+      nice_levels.reserve(capacity);
+      arrival.reserve(capacity);
+      generation.reserve(capacity);
+      links.reserve(capacity);
+      groups.reserve(capacity);
+      phase.reserve(capacity);
+      slept.reserve(capacity);
+      timers.reserve(capacity);
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Admit - store a new task @id arriving on tick @arrival_tick to run
+    //         for @ticks at @nice in group @group, starting at
+    //         @start_vruntime; return its handle. It runs in a single
+    //         burst unless given others by nextBurst. With id kNoID, the
+    //         slot is instead the entity of group @group
+    TaskHandle Admit(char id, uint64_t ticks, int nice,
+                     uint64_t start_vruntime, uint64_t arrival_tick = 0,
+                     uint32_t group = 0) {
+      uint32_t i;
+      if (!free_slots.empty()) {
+        i = free_slots.front();
+        free_slots.pop_front();
+      } else {
+        if (ids.size() == kMaxTasks)
+          throw std::length_error("task pool full");
+        i = static_cast<uint32_t>(ids.size());
+        vruntime.push_back(0);
+        runtime.push_back(0);
+        duration.push_back(0);
+        burst_end.push_back(0);
+        vruntime_step.push_back(0);
+        ids.push_back(0);
+        nice_levels.push_back(0);
+        arrival.push_back(0);
+        // Generation 0 is left for the null handle
+        generation.push_back(1);
+        links.push_back(RbLinks<TaskHandle>());
+        groups.push_back(0);
+        phase.push_back(0);
+        slept.push_back(0);
+        timers.push_back(TimerLinks<TaskHandle>());
+      }
+      vruntime[i] = start_vruntime;
+      runtime[i] = 0;
+      duration[i] = ticks;
+      burst_end[i] = ticks;
+      phase[i] = 0;
+      slept[i] = 0;
+      vruntime_step[i] = vruntimeStep(nice);
+      ids[i] = id;
+      arrival[i] = arrival_tick;
+      nice_levels[i] = static_cast<int8_t>(nice);
+      groups[i] = group;
+      live++;
+      return TaskHandle(static_cast<uint32_t>(generation[i]) << kIndexBits |
+                        i);
+    }
+
+    // Release - free the slot of @h, leaving every handle to it stale
+    void Release(TaskHandle h) {
+      uint32_t i = Index(Check(h));
+      // Freed slots hold no id, so Find skips them
+      ids[i] = kNoID;
+      live--;
+      // A slot out of generations is never reused, or a handle from its
+      // first one would match again
+      if (generation[i] == kMaxGeneration)
+        return;
+      generation[i]++;
+      free_slots.push_back(i);
+    }
+
+    // Valid - return true if @h refers to a task still in the pool
+    bool Valid(TaskHandle h) const {
+      uint32_t i = Index(h);
+      return i < ids.size() && generation[i] == Generation(h);
+    }
+
+    // Check - return @h, throwing if it is stale
+    TaskHandle Check(TaskHandle h) const {
+      if (!Valid(h))
+        throw std::logic_error("stale task handle");
+      return h;
+    }
+
+    // Find - return handle of the task in the lowest slot with @id, null
+    //        if none; scans every slot
+    TaskHandle Find(char id) const {
+      for (std::size_t i = 0; i < ids.size(); i++)
+        if (ids[i] == id && id != kNoID)
+          return TaskHandle(static_cast<uint32_t>(generation[i]) <<
+                            kIndexBits | static_cast<uint32_t>(i));
+      return TaskHandle();
+    }
+
+    // Size - return # of tasks & group entities in the pool
+    std::size_t Size(void) const {
+      return live;
+    }
+
+    // getID - return the task's id
+    char getID(TaskHandle h) const {
+      return ids[Index(h)];
+    }
+
+    // getGroup - return the group the task runs in, or that the group
+    //            entity stands for
+    uint32_t getGroup(TaskHandle h) const {
+      return groups[Index(h)];
+    }
+
+    // isGroup - return true if @h is the entity of a group
+    bool isGroup(TaskHandle h) const {
+      return ids[Index(h)] == kNoID;
+    }
+
+    // getArrival - return the tick the task arrived on
+    uint64_t getArrival(TaskHandle h) const {
+      return arrival[Index(h)];
+    }
+
+    // getDuration - return the task's total runtime
+    uint64_t getDuration(TaskHandle h) const {
+      return duration[Index(h)];
+    }
+
+    // getNice - return the task's nice level
+    int getNice(TaskHandle h) const {
+      return nice_levels[Index(h)];
+    }
+
+    // setNice - move the task to @nice, charging later ticks at its weight
+    void setNice(TaskHandle h, int nice) {
+      uint32_t i = Index(h);
+      nice_levels[i] = static_cast<int8_t>(nice);
+      vruntime_step[i] = vruntimeStep(nice);
+    }
+
+    // hasRun - return true if the task has run for at least one tick
+    bool hasRun(TaskHandle h) const {
+      return runtime[Index(h)] != 0;
+    }
+
+    // getvRuntime - return the task's vRuntime, in 32.32 fixed point
+    //               ticks that wrap around (see vruntime.h)
+    uint64_t getvRuntime(TaskHandle h) const {
+      return vruntime[Index(h)];
+    }
+
+    // setvRuntime - set the task's vRuntime to @v
+    void setvRuntime(TaskHandle h, uint64_t v) {
+      vruntime[Index(h)] = v;
+    }
+
+    // getRemaining - return # of ticks left until completion
+    uint64_t getRemaining(TaskHandle h) const {
+      uint32_t i = Index(h);
+      return duration[i] - runtime[i];
+    }
+
+    // incRunTimes - increment runtime & weight-scaled vruntime of task
+    void incRunTimes(TaskHandle h) {
+      uint32_t i = Index(h);
+      runtime[i]++;
+      vruntime[i] += vruntime_step[i];
+    }
+
+    // incRunTimes - advance runtime & vruntime of task by @ticks at once
+    void incRunTimes(TaskHandle h, uint64_t ticks) {
+      uint32_t i = Index(h);
+      runtime[i] += ticks;
+      vruntime[i] += ticks * vruntime_step[i];
+    }
+
+    // ticksUntilPast - # of ticks the task must run, at least one, until
+    //                  its vRuntime comes after @bound
+    uint64_t ticksUntilPast(TaskHandle h, uint64_t bound) const {
+      uint32_t i = Index(h);
+      int64_t lag = static_cast<int64_t>(bound - vruntime[i]);
+      if (lag < 0)
+        return 1;
+      return static_cast<uint64_t>(lag) / vruntime_step[i] + 1;
+    }
+
+    // burstDone - check if task has run to the end of its current burst,
+    //             at completion or before it sleeps
+    bool burstDone(TaskHandle h) const {
+      uint32_t i = Index(h);
+      return runtime[i] == burst_end[i];
+    }
+
+    // getBurstRemaining - return # of ticks left in the current burst
+    uint64_t getBurstRemaining(TaskHandle h) const {
+      uint32_t i = Index(h);
+      return burst_end[i] - runtime[i];
+    }
+
+    // nextBurst - give the task a burst of @ticks from its runtime so far,
+    //             its burst sequence going on at @next_phase
+    void nextBurst(TaskHandle h, uint64_t ticks, uint64_t next_phase) {
+      uint32_t i = Index(h);
+      burst_end[i] = runtime[i] + ticks;
+      phase[i] = next_phase;
+    }
+
+    // getPhase - return where the task's burst sequence goes on after the
+    //            current burst, as given to nextBurst
+    uint64_t getPhase(TaskHandle h) const {
+      return phase[Index(h)];
+    }
+
+    // addSlept - count @ticks the task slept
+    void addSlept(TaskHandle h, uint64_t ticks) {
+      slept[Index(h)] += ticks;
+    }
+
+    // getSlept - return # of ticks the task slept so far
+    uint64_t getSlept(TaskHandle h) const {
+      return slept[Index(h)];
+    }
+
+    // getTimerLinks - return timer wheel links of the task, valid only
+    //                 while the task waits on a wheel
+    TimerLinks<TaskHandle>& getTimerLinks(TaskHandle h) {
+      return timers[Index(h)];
+    }
+
+    // getLinks - return timeline links of the task, valid only while the
+    //            task sits on a timeline
+    RbLinks<TaskHandle>& getLinks(TaskHandle h) {
+      return links[Index(h)];
+    }
+
+    // isComplete - check if task has run for its whole duration
+    bool isComplete(TaskHandle h) const {
+      uint32_t i = Index(h);
+      return runtime[i] == duration[i];
+    }
+
+ private:
+    static const uint32_t kIndexMask = kMaxTasks - 1;
+    static const uint8_t kMaxGeneration = 0xff;
+
+    // Fields read or written every tick, one array each
+    std::vector<uint64_t> vruntime;
+    std::vector<uint64_t> runtime;
+    std::vector<uint64_t> duration;
+    std::vector<uint64_t> burst_end;
+    std::vector<uint64_t> vruntime_step;
+    // Fields read only when dispatching, reporting or checking handles
+    std::vector<char> ids;
+    std::vector<int8_t> nice_levels;
+    std::vector<uint64_t> arrival;
+    std::vector<uint8_t> generation;
+    std::vector<uint32_t> groups;
+    // Fields read only when a burst ends
+    std::vector<uint64_t> phase;
+    std::vector<uint64_t> slept;
+    // Timeline links, touched when enqueuing or dequeuing
+    std::vector<RbLinks<TaskHandle>> links;
+    // Timer wheel links, touched when sleeping or waking
+    std::vector<TimerLinks<TaskHandle>> timers;
+    // Freed slots, reused oldest first so each goes through its
+    // generations as slowly as possible
+    std::deque<uint32_t> free_slots;
+    std::size_t live = 0;
+
+    static uint32_t Index(TaskHandle h) {
+      return h.value & kIndexMask;
+    }
+
+    static uint8_t Generation(TaskHandle h) {
+      return static_cast<uint8_t>(h.value >> kIndexBits);
+    }
+};
+
+#endif  // TASK_POOL_H_
@@ -0,0 +1,1182 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// test_cfs_sched.cc - Unit tester for cfs_sched.h
+//
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_runner.h"
+#include "cfs_sched.h"
+#include "smp_sched.h"
+#include "workload_gen.h"
+
+// runFile - load, order & run the tasks in @file_name, returning output
+std::string runFile(const char *file_name, bool fast_forward = false,
+                    bool ranges = false) {
+  std::vector<Task> task_list;
+  std::ifstream data_file(file_name);
+  EXPECT_TRUE(data_file.is_open());
+  storeData(task_list, data_file);
+  organizeTasks(task_list);
+
+  testing::internal::CaptureStdout();
+  if (ranges) {
+    RunLengthSink sink(std::cout);
+    runCFS(task_list, sink, fast_forward);
+  } else {
+    runCFS(task_list, fast_forward);
+  }
+  return testing::internal::GetCapturedStdout();
+}
+
+// runStream - run the tasks in @text fed through a pipe as a TaskStream,
+//             returning output
+std::string runStream(const std::string& text, bool fast_forward = false) {
+  int fds[2];
+  EXPECT_EQ(pipe(fds), 0);
+  // Writer fills the pipe in small pieces while the scheduler reads
+  std::thread writer([&text, fds] {
+    for (std::size_t i = 0; i < text.size(); i += 1000) {
+      std::size_t n = std::min<std::size_t>(1000, text.size() - i);
+      EXPECT_EQ(write(fds[1], text.data() + i, n), static_cast<ssize_t>(n));
+    }
+    close(fds[1]);
+  });
+
+  testing::internal::CaptureStdout();
+  std::exception_ptr error;
+  try {
+    TextSink sink(std::cout);
+    TaskStream tasks(fds[0], &sink);
+    runCFS(tasks, sink, fast_forward);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  writer.join();
+  close(fds[0]);
+  std::string output = testing::internal::GetCapturedStdout();
+  // Parse errors surface only once the writer is done
+  if (error)
+    std::rethrow_exception(error);
+  return output;
+}
+
+// 1) Check tasks arriving together & interleaving
+TEST(Scheduler, Tasks1) {
+  EXPECT_EQ(runFile("tasks1.dat"),
+    "0 [0]: _\n"
+    "1 [1]: A\n"
+    "2 [3]: B\n"
+    "3 [3]: C\n"
+    "4 [3]: C\n"
+    "5 [3]: A\n"
+    "6 [3]: B\n"
+    "7 [3]: B\n"
+    "8 [3]: C*\n"
+    "9 [2]: A*\n"
+    "10 [1]: B*\n");
+}
+
+// 2) Check idle ticks before & between tasks
+TEST(Scheduler, Tasks2) {
+  EXPECT_EQ(runFile("tasks2.dat"),
+    "0 [0]: _\n"
+    "1 [0]: _\n"
+    "2 [1]: A\n"
+    "3 [1]: A\n"
+    "4 [1]: A\n"
+    "5 [1]: A*\n"
+    "6 [0]: _\n"
+    "7 [1]: B\n"
+    "8 [1]: B*\n");
+}
+
+// 3) Check arrivals at tick 0 & while another task is running
+TEST(Scheduler, Tasks3) {
+  EXPECT_EQ(runFile("tasks3.dat"),
+    "0 [2]: B\n"
+    "1 [2]: N\n"
+    "2 [2]: N\n"
+    "3 [3]: B\n"
+    "4 [3]: V\n"
+    "5 [3]: V\n"
+    "6 [3]: N\n"
+    "7 [3]: B\n"
+    "8 [3]: B\n"
+    "9 [3]: V*\n"
+    "10 [2]: N\n"
+    "11 [2]: N*\n"
+    "12 [1]: B\n"
+    "13 [1]: B*\n");
+}
+
+// 4) Check arrivals are admitted by start time, then id, regardless of
+//    file order
+TEST(Scheduler, UnorderedArrivals) {
+  std::vector<Task> task_list{Task('C', 3, 1), Task('B', 0, 1),
+                              Task('A', 3, 1), Task('D', 1, 1)};
+  organizeTasks(task_list);
+
+  testing::internal::CaptureStdout();
+  runCFS(task_list);
+  EXPECT_EQ(testing::internal::GetCapturedStdout(),
+    "0 [1]: B*\n"
+    "1 [1]: D*\n"
+    "2 [0]: _\n"
+    "3 [2]: A*\n"
+    "4 [1]: C*\n");
+}
+
+// 5) Check fast-forwarding expands to the same per-tick output
+TEST(Scheduler, FastForward) {
+  for (auto file_name : {"tasks1.dat", "tasks2.dat", "tasks3.dat"}) {
+    EXPECT_EQ(runFile(file_name, true), runFile(file_name));
+  }
+}
+
+// 6) Check runs of the same task & # of tasks compress into tick ranges,
+//    whether ticks are reported one at a time or per stretch
+TEST(Scheduler, RunLengthRanges) {
+  EXPECT_EQ(runFile("tasks1.dat", false, true),
+            runFile("tasks1.dat", true, true));
+  EXPECT_EQ(runFile("tasks3.dat", false, true),
+            runFile("tasks3.dat", true, true));
+  EXPECT_EQ(runFile("tasks1.dat", true, true),
+    "0 [0]: _\n"
+    "1 [1]: A\n"
+    "2 [3]: B\n"
+    "3-4 [3]: C\n"
+    "5 [3]: A\n"
+    "6-7 [3]: B\n"
+    "8 [3]: C*\n"
+    "9 [2]: A*\n"
+    "10 [1]: B*\n");
+  EXPECT_EQ(runFile("tasks2.dat", false, true),
+    "0-1 [0]: _\n"
+    "2-5 [1]: A*\n"
+    "6 [0]: _\n"
+    "7-8 [1]: B*\n");
+}
+
+// 7) Check mapped loading matches stream extraction on every task file
+TEST(Loader, MatchesStoreData) {
+  for (auto file_name : {"tasks1.dat", "tasks2.dat", "tasks3.dat"}) {
+    std::vector<Task> stored, loaded;
+    std::ifstream data_file(file_name);
+    storeData(stored, data_file);
+    loadTasks(loaded, file_name);
+
+    ASSERT_EQ(loaded.size(), stored.size());
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+      std::ostringstream expected, actual;
+      expected << stored[i];
+      actual << loaded[i];
+      EXPECT_EQ(actual.str(), expected.str());
+    }
+  }
+}
+
+// 8) Check scanner accepts blank lines, tabs & CRLF line endings
+TEST(Loader, ScannerWhitespace) {
+  std::string text = "\nA 1 3\r\n\n\tB\t2  4\nC 5 6";
+  TaskScanner scanner(text.data(), text.data() + text.size());
+  TaskRecord rec;
+
+  ASSERT_TRUE(scanner.Next(rec));
+  EXPECT_EQ(rec.id, 'A');
+  EXPECT_EQ(rec.start_time, 1u);
+  EXPECT_EQ(rec.duration, 3u);
+  ASSERT_TRUE(scanner.Next(rec));
+  EXPECT_EQ(rec.id, 'B');
+  EXPECT_EQ(rec.duration, 4u);
+  ASSERT_TRUE(scanner.Next(rec));
+  EXPECT_EQ(rec.id, 'C');
+  EXPECT_EQ(rec.duration, 6u);
+  EXPECT_FALSE(scanner.Next(rec));
+}
+
+// 9) Check malformed records report their line & column
+TEST(Loader, ScannerErrors) {
+  struct Case {
+    const char *text;
+    std::size_t line;
+    std::size_t column;
+  };
+  std::vector<Case> cases{{"A 1 3\nB 2 x\n", 2, 5},
+                          {"A 1 3\n\n  AB 2 3\n", 3, 4},
+                          {"A 1 99999999999999999999\n", 1, 5},
+                          {"A 1 3 4 5\n", 1, 9},
+                          {"A 1 3 -21\n", 1, 7},
+                          {"A 1 3 20\n", 1, 7},
+                          {"A 1 3 4x\n", 1, 8},
+                          {"A -1 3\n", 1, 3},
+                          {"A 1", 1, 4},
+                          {"A 1 3 /a//b\n", 1, 10},
+                          {"A 1 3 /a/\n", 1, 9},
+                          {"A 1 3 -1 /a b\n", 1, 13},
+                          {"A 1 3 /a 1\n", 1, 10},
+                          {"A 1 2:\n", 1, 7},
+                          {"A 1 2:0:1\n", 1, 7},
+                          {"A 1 0:3:1\n", 1, 5},
+                          {"A 1 2:3\n", 1, 8},
+                          {"A 1 2:3:0\n", 1, 9},
+                          {"A 1 2:3:1x\n", 1, 10}};
+
+  for (auto& c : cases) {
+    std::string text(c.text);
+    TaskScanner scanner(text.data(), text.data() + text.size());
+    TaskRecord rec;
+    try {
+      while (scanner.Next(rec)) {}
+      ADD_FAILURE() << "no error for " << text;
+    } catch (const TaskParseError& e) {
+      EXPECT_EQ(e.getLine(), c.line) << text;
+      EXPECT_EQ(e.getColumn(), c.column) << text;
+    }
+  }
+}
+
+// 10) Check streamed tasks run as if loaded & ordered up front
+TEST(Stream, MatchesFile) {
+  for (auto file_name : {"tasks1.dat", "tasks2.dat", "tasks3.dat"}) {
+    std::ifstream data_file(file_name);
+    std::stringstream text;
+    text << data_file.rdbuf();
+    EXPECT_EQ(runStream(text.str()), runFile(file_name));
+    EXPECT_EQ(runStream(text.str(), true), runFile(file_name));
+  }
+}
+
+// 11) Check a stream spanning many reads & partial lines
+TEST(Stream, LongStream) {
+  std::string text;
+  std::vector<Task> task_list;
+  for (unsigned int i = 0; i < 20000; i++) {
+    char id = static_cast<char>('Z' - i % 26);
+    unsigned int start = i / 3 * 2;
+    unsigned int duration = 1 + i % 5;
+    text += std::string(1, id) + " " + std::to_string(start) + " " +
+      std::to_string(duration) + "\n";
+    task_list.push_back(Task(id, start, duration));
+  }
+  organizeTasks(task_list);
+
+  testing::internal::CaptureStdout();
+  runCFS(task_list, true);
+  EXPECT_EQ(runStream(text, true), testing::internal::GetCapturedStdout());
+}
+
+// 12) Check a task arriving out of start time order is rejected
+TEST(Stream, OutOfOrder) {
+  try {
+    runStream("A 0 2\n\nB 5 1\nC 4 1\n");
+    FAIL() << "no error for out of order start time";
+  } catch (const TaskParseError& e) {
+    EXPECT_EQ(e.getLine(), 4u);
+  }
+}
+
+// runSMPFile - load, order & run the tasks in @file_name over @cpus
+//              CPUs, returning the summary
+std::string runSMPFile(const char *file_name, unsigned int cpus) {
+  std::vector<Task> task_list;
+  loadTasks(task_list, file_name);
+  organizeTasks(task_list);
+  TaskListSource tasks(task_list);
+  std::ostringstream os;
+  runSMP(tasks, cpus, os);
+  return os.str();
+}
+
+// 13) Check a single CPU takes as long as the uniprocessor scheduler
+TEST(SMP, OneCPU) {
+  EXPECT_EQ(runSMPFile("tasks1.dat", 1),
+    "ticks: 11\n"
+    "cpu 0: busy 10 (90.9%) migrations in 0 out 0\n"
+    "total: busy 10 (90.9%) migrations 0\n");
+  EXPECT_EQ(runSMPFile("tasks2.dat", 1),
+    "ticks: 9\n"
+    "cpu 0: busy 6 (66.7%) migrations in 0 out 0\n"
+    "total: busy 6 (66.7%) migrations 0\n");
+}
+
+// 14) Check a CPU left idle pulls a waiting task from a busier one
+TEST(SMP, IdlePull) {
+  EXPECT_EQ(runSMPFile("tasks3.dat", 2),
+    "ticks: 8\n"
+    "cpu 0: busy 6 (75.0%) migrations in 0 out 1\n"
+    "cpu 1: busy 8 (100.0%) migrations in 1 out 0\n"
+    "total: busy 14 (87.5%) migrations 1\n");
+}
+
+// 15) Check every tick of work is done exactly once whatever the # of
+//     CPUs, & no task is lost or duplicated by migrations
+TEST(SMP, ConservesWork) {
+  for (unsigned int n_cpus : {2u, 3u, 8u, 64u}) {
+    std::vector<Task> task_list;
+    uint64_t work = 0;
+    uint32_t seed = n_cpus;
+    for (unsigned int i = 0; i < 5000; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      unsigned int duration = 1 + (seed >> 16) % 40;
+      task_list.push_back(Task(static_cast<char>('A' + i % 26),
+                               i / 4, duration));
+      work += duration;
+    }
+    organizeTasks(task_list);
+    TaskListSource tasks(task_list);
+    SmpScheduler smp(tasks, n_cpus);
+    do {
+      smp.appendTimeline();
+      smp.balance();
+      smp.schedule();
+      smp.runTick();
+      smp.incrementTick();
+    } while (!smp.done());
+
+    uint64_t busy = 0, in = 0, out = 0;
+    for (unsigned int i = 0; i < n_cpus; i++) {
+      busy += smp.getCPU(i).getBusyTicks();
+      in += smp.getCPU(i).getMigrationsIn();
+      out += smp.getCPU(i).getMigrationsOut();
+    }
+    EXPECT_EQ(busy, work);
+    EXPECT_EQ(in, out);
+    // Tasks never wait while a CPU sits idle for long, so the run
+    // stays close to the ideal length
+    EXPECT_LE(smp.getTicks(), work / n_cpus + 5000 / 4 + 40);
+  }
+}
+
+// 16) Check every job runs exactly once however the threads steal
+TEST(Batch, PoolRunsEachJobOnce) {
+  std::vector<std::atomic<int>> runs(1000);
+  for (auto& r : runs)
+    r = 0;
+  for (unsigned int threads : {1u, 3u, 8u}) {
+    WorkStealingPool pool(threads);
+    pool.Run(runs.size(), [&runs](std::size_t i) {
+      runs[i]++;
+    });
+  }
+  for (auto& r : runs)
+    EXPECT_EQ(r, 3);
+}
+
+// 17) Check merged batch output matches single-file runs in input order
+//     & a missing file fails on its own
+TEST(Batch, MatchesSingleRuns) {
+  std::vector<std::string> files{"tasks3.dat", "tasks1.dat", "missing.dat",
+                                 "tasks2.dat", "tasks1.dat"};
+  for (bool ranges : {false, true}) {
+    RunOptions options;
+    options.ranges = ranges;
+    WorkStealingPool pool(4);
+    std::ostringstream os, err;
+    BatchResult result = runBatch(files, options, "", pool, os, err);
+
+    std::string expected;
+    for (auto& file : files)
+      if (file != "missing.dat")
+        expected += "==> " + file + " <==\n" +
+          runFile(file.c_str(), false, ranges);
+    EXPECT_EQ(os.str(), expected);
+    EXPECT_EQ(err.str(), "Error: cannot open file missing.dat\n");
+    EXPECT_EQ(result.workloads, 5u);
+    EXPECT_EQ(result.failed, 1u);
+  }
+}
+
+// nicedTasks - random workload whose tasks have mixed nice levels
+std::vector<Task> nicedTasks(uint32_t seed) {
+  std::vector<Task> task_list;
+  for (unsigned int i = 0; i < 300; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    task_list.push_back(Task(static_cast<char>('A' + i % 26), i / 2,
+                             1 + (seed >> 8) % 30,
+                             kMinNice + (seed >> 20) % kNiceLevels));
+  }
+  organizeTasks(task_list);
+  return task_list;
+}
+
+// 18) Check the nice column is parsed, defaulting to 0
+TEST(Nice, Loader) {
+  std::string text = "A 0 3\nB 1 2 -20\nC 2 1 +19\n";
+  TaskScanner scanner(text.data(), text.data() + text.size());
+  TaskRecord rec;
+  std::vector<int> nices;
+  while (scanner.Next(rec))
+    nices.push_back(rec.nice);
+  EXPECT_EQ(nices, std::vector<int>({0, -20, 19}));
+}
+
+// 19) Check CPU time is shared in proportion to the nice weights
+TEST(Nice, WeightedShare) {
+  std::vector<Task> task_list{Task('A', 0, 400, 0),
+                              Task('B', 0, 400, 5)};
+  testing::internal::CaptureStdout();
+  runCFS(task_list);
+  std::istringstream lines(testing::internal::GetCapturedStdout());
+  std::string line;
+  unsigned int a_ticks = 0;
+  for (int tick = 0; tick < 400 && std::getline(lines, line); tick++)
+    if (line.back() == 'A')
+      a_ticks++;
+  // 1024 / (1024 + 335) of 400 ticks
+  EXPECT_NEAR(a_ticks, 301, 3);
+}
+
+// 20) Check fast-forwarding predicts weighted preemptions exactly
+TEST(Nice, FastForward) {
+  for (uint32_t seed : {1u, 2u, 3u}) {
+    std::vector<Task> ticked = nicedTasks(seed);
+    std::vector<Task> jumped = nicedTasks(seed);
+    testing::internal::CaptureStdout();
+    runCFS(ticked);
+    std::string expected = testing::internal::GetCapturedStdout();
+    testing::internal::CaptureStdout();
+    runCFS(jumped, true);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expected);
+  }
+}
+
+// runFrom - run @task_list to completion with min_vruntime starting at
+//           @initial_vruntime, returning output
+std::string runFrom(std::vector<Task> task_list, uint64_t initial_vruntime,
+                    bool fast_forward) {
+  std::ostringstream os;
+  TextSink sink(os);
+  TaskListSource tasks(task_list);
+  Scheduler cfs(tasks, sink, initial_vruntime);
+  do {
+    cfs.appendTimeline();
+    cfs.moveNextTask();
+    cfs.getNextTask();
+    if (fast_forward) {
+      cfs.runStretch(cfs.ticksUntilEvent());
+      continue;
+    }
+    cfs.incrementTask();
+    cfs.printStatus();
+    cfs.purgeCompletion();
+    cfs.incrementTick();
+  } while (!cfs.done());
+  sink.Flush();
+  return os.str();
+}
+
+// 21) Check timeline keys keep their order across the wrap point
+TEST(Wrap, TimelineOrder) {
+  Multimap<VRuntime, int> timeline;
+  std::vector<int> offsets{3, -2, 0, 5, -7, 1, -1, 2};
+  for (int off : offsets)
+    timeline.Insert(VRuntime(static_cast<uint64_t>(off)), off);
+
+  std::sort(offsets.begin(), offsets.end());
+  for (int off : offsets)
+    EXPECT_EQ(timeline.PopMin(), off);
+}
+
+// 22) Check scheduling is the same whether vruntime wraps mid-run or not
+TEST(Wrap, SchedulingOrder) {
+  std::string expected = runFrom(nicedTasks(4), 0, false);
+  // Wrap after 50 ticks, halfway round & at the default start
+  for (uint64_t initial : {-(uint64_t(50) << 32), uint64_t(1) << 63,
+                           kInitialVRuntime}) {
+    EXPECT_EQ(runFrom(nicedTasks(4), initial, false), expected);
+    EXPECT_EQ(runFrom(nicedTasks(4), initial, true), expected);
+  }
+}
+
+// 23) Check ticks & durations past 32 bits
+TEST(Wrap, LongHorizon) {
+  std::vector<Task> task_list{Task('A', 5000000000, 3000000000),
+                              Task('B', 5000000000, 1)};
+  std::ostringstream os;
+  {
+    RunLengthSink sink(os);
+    runCFS(task_list, sink, true);
+  }
+  EXPECT_EQ(os.str(),
+    "0-4999999999 [0]: _\n"
+    "5000000000 [2]: A\n"
+    "5000000001 [2]: B*\n"
+    "5000000002-8000000000 [1]: A*\n");
+}
+
+// 24) Check freed slots are reused & old handles to them are rejected
+TEST(Pool, RecyclesSlots) {
+  TaskPool pool;
+  TaskHandle a = pool.Admit('A', 2, 0, 0);
+  TaskHandle b = pool.Admit('B', 1, 0, 0);
+  EXPECT_FALSE(a.isNull());
+  EXPECT_NE(a, b);
+  EXPECT_EQ(pool.Size(), 2u);
+
+  pool.Release(a);
+  EXPECT_FALSE(pool.Valid(a));
+  EXPECT_THROW(pool.Check(a), std::logic_error);
+  EXPECT_THROW(pool.Release(a), std::logic_error);
+  EXPECT_FALSE(pool.Valid(TaskHandle()));
+
+  // The freed slot is taken again under a new generation
+  TaskHandle c = pool.Admit('C', 3, 0, 7);
+  EXPECT_NE(c, a);
+  EXPECT_FALSE(pool.Valid(a));
+  EXPECT_TRUE(pool.Valid(b) && pool.Valid(c));
+  EXPECT_EQ(pool.getID(c), 'C');
+  EXPECT_EQ(pool.getvRuntime(c), 7u);
+  EXPECT_EQ(pool.getRemaining(c), 3u);
+  EXPECT_EQ(pool.Size(), 2u);
+}
+
+// 25) Check run state is tracked per slot & generations skip null
+TEST(Pool, RunState) {
+  TaskPool pool;
+  TaskHandle h = pool.Admit('A', 3, 5, 0);
+  pool.incRunTimes(h);
+  EXPECT_EQ(pool.getvRuntime(h), vruntimeStep(5));
+  pool.incRunTimes(h, 2);
+  EXPECT_TRUE(pool.isComplete(h));
+  EXPECT_EQ(pool.getRemaining(h), 0u);
+
+  // Later ticks are charged at the new weight
+  pool.setNice(h, -5);
+  EXPECT_EQ(pool.getNice(h), -5);
+  EXPECT_EQ(pool.ticksUntilPast(h, pool.getvRuntime(h) + vruntimeStep(-5)),
+            2u);
+  EXPECT_EQ(pool.Find('A'), h);
+  EXPECT_TRUE(pool.Find('B').isNull());
+
+  // Cycle slots through every generation, never handing out null
+  for (int i = 0; i < 600; i++) {
+    pool.Release(h);
+    h = pool.Admit('A', 1, 0, 0);
+    ASSERT_FALSE(h.isNull());
+    ASSERT_TRUE(pool.Valid(h));
+  }
+  EXPECT_EQ(pool.Size(), 1u);
+  EXPECT_EQ(pool.Find('A'), h);
+  pool.Release(h);
+  EXPECT_TRUE(pool.Find('A').isNull());
+}
+
+// 26) Check generated files are reproducible, ordered & loadable
+TEST(Workload, Generator) {
+  for (auto arrivals : {"poisson", "bursty", "batch"}) {
+    for (auto durations : {"uniform", "heavy-tail", "bimodal"}) {
+      WorkloadSpec spec;
+      spec.tasks = 2000;
+      spec.burst = 8;
+      spec.arrivals = parseArrivals(arrivals);
+      spec.durations = parseDurations(durations);
+      spec.nice = true;
+      std::ostringstream first, second;
+      writeWorkload(spec, first);
+      writeWorkload(spec, second);
+      EXPECT_EQ(first.str(), second.str());
+
+      std::string text = first.str();
+      TaskScanner scanner(text.data(), text.data() + text.size());
+      TaskRecord rec;
+      uint64_t tasks = 0, last_start = 0, total = 0;
+      while (scanner.Next(rec)) {
+        EXPECT_GE(rec.start_time, last_start);
+        EXPECT_GE(rec.duration, 1u);
+        EXPECT_LE(rec.duration, 1000 * spec.mean_duration);
+        last_start = rec.start_time;
+        total += rec.duration;
+        tasks++;
+      }
+      EXPECT_EQ(tasks, spec.tasks);
+      // Every distribution keeps the requested mean
+      EXPECT_NEAR(static_cast<double>(total) / tasks, spec.mean_duration,
+                  spec.mean_duration * 0.25) << arrivals << " " << durations;
+      // So does every arrival process
+      EXPECT_NEAR(tasks / (last_start + 1.0), spec.rate, spec.rate * 0.25)
+        << arrivals << " " << durations;
+    }
+  }
+}
+
+// 27) Check a batch shares its start & run totals match the output
+TEST(Workload, RunStats) {
+  WorkloadSpec spec;
+  spec.tasks = 500;
+  spec.arrivals = Arrivals::kBatch;
+  spec.burst = 100;
+  std::ostringstream text;
+  writeWorkload(spec, text);
+  std::istringstream lines(text.str());
+  std::string line;
+  std::getline(lines, line);
+  EXPECT_EQ(line.substr(0, 4), "A 0 ");
+  for (int i = 1; i < 100; i++)
+    std::getline(lines, line);
+  EXPECT_EQ(line.substr(0, 4), "V 0 ");
+  std::getline(lines, line);
+  EXPECT_EQ(line.substr(0, 7), "W 1000 ");
+
+  char file_name[] = "/tmp/test_workloadXXXXXX";
+  int fd = mkstemp(file_name);
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(write(fd, text.str().data(), text.str().size()),
+            static_cast<ssize_t>(text.str().size()));
+  close(fd);
+  std::vector<Task> task_list;
+  loadTasks(task_list, file_name);
+  unlink(file_name);
+  organizeTasks(task_list);
+
+  for (bool fast_forward : {false, true}) {
+    NullSink sink;
+    RunStats stats = runCFS(task_list, sink, fast_forward);
+    std::ostringstream os;
+    RunLengthSink ranges(os);
+    runCFS(task_list, ranges, fast_forward);
+    // Every tick is reported, each dispatch ends in a preemption or a
+    // completion
+    std::string out = os.str();
+    std::size_t last = out.rfind('\n', out.size() - 2) + 1;
+    std::string range = out.substr(last, out.find(' ', last) - last);
+    EXPECT_EQ(stats.ticks, std::stoull(range.substr(range.find('-') + 1)) + 1);
+    EXPECT_EQ(stats.completed, task_list.size());
+    EXPECT_GE(stats.dispatches, stats.completed);
+    if (!fast_forward) {
+      EXPECT_EQ(sink.getReports(), stats.ticks);
+    }
+  }
+}
+
+// 28) Check histogram buckets are exact for small values & within 1/64
+//     above, & percentiles come from the right buckets
+TEST(Latency, Histogram) {
+  for (uint64_t v : {uint64_t(0), uint64_t(127), uint64_t(128),
+                     uint64_t(1000), uint64_t(123456789), ~uint64_t(0)}) {
+    std::size_t i = LatencyHistogram::Index(v);
+    ASSERT_LT(i, std::size_t(LatencyHistogram::kBuckets));
+    uint64_t top = LatencyHistogram::Highest(i);
+    EXPECT_GE(top, v);
+    EXPECT_LE(top - v, v / 64);
+    if (i > 0) {
+      EXPECT_LT(LatencyHistogram::Highest(i - 1), v);
+    }
+  }
+
+  LatencyHistogram h;
+  for (uint64_t v = 1; v <= 1000; v++)
+    h.Record(v);
+  EXPECT_EQ(h.Count(), 1000u);
+  EXPECT_EQ(h.Max(), 1000u);
+  EXPECT_EQ(h.Percentile(10), 100u);
+  EXPECT_NEAR(h.Percentile(50), 500, 500 / 64);
+  EXPECT_NEAR(h.Percentile(99), 990, 990 / 64);
+  EXPECT_EQ(h.Percentile(100), 1000u);
+}
+
+// 29) Check per-task latency of tasks1.dat & that periodic reports are
+//     the same with fast-forwarding
+TEST(Latency, Tasks1) {
+  std::vector<Task> task_list;
+  loadTasks(task_list, "tasks1.dat");
+  organizeTasks(task_list);
+
+  std::ostringstream reports[2];
+  for (bool fast_forward : {false, true}) {
+    NullSink sink;
+    LatencyStats latency(reports[fast_forward], 4);
+    runCFS(task_list, sink, fast_forward, &latency);
+    // A & B run on arrival, C waits a tick behind B
+    EXPECT_EQ(latency.getResponse().Count(), 3u);
+    EXPECT_EQ(latency.getResponse().Max(), 1u);
+    // A: 1-9, B: 2-10 & C: 2-8, for 3, 4 & 3 ticks
+    EXPECT_EQ(latency.getTurnaround().Max(), 9u);
+    EXPECT_EQ(latency.getWait().Max(), 6u);
+    EXPECT_GT(latency.Jain(), 0.9);
+    EXPECT_LE(latency.Jain(), 1.0);
+  }
+  EXPECT_EQ(reports[0].str(), reports[1].str());
+  EXPECT_NE(reports[0].str().find("latency at tick 8: completed 0\n"),
+            std::string::npos);
+  EXPECT_NE(reports[0].str().find("latency at tick 11: completed 3\n"),
+            std::string::npos);
+}
+
+// 30) Check the leftmost waiting tasks listed after periodic reports
+TEST(Latency, TopReport) {
+  std::vector<Task> task_list;
+  loadTasks(task_list, "tasks1.dat");
+  organizeTasks(task_list);
+
+  NullSink sink;
+  std::ostringstream report;
+  LatencyStats latency(report, 3);
+  runCFS(task_list, sink, false, &latency, 1);
+  EXPECT_NE(report.str().find("timeline at tick 3: running B waiting 2\n"
+                              "  C lag 0 remaining 3 nice 0\n"
+                              "latency at tick 6"), std::string::npos);
+  EXPECT_NE(report.str().find("timeline at tick 9: running - waiting 2\n"
+                              "  A lag 0 remaining 1 nice 0\n"),
+            std::string::npos);
+  // No listing follows the final report
+  EXPECT_EQ(report.str().find("timeline at tick 11"), std::string::npos);
+}
+
+// runControlled - run @task_list, its groups named in @groups & its
+//                 bursts stored in @bursts, calling @control with the
+//                 scheduler at the start of tick @tick; return output
+std::string runControlled(std::vector<Task> task_list, uint64_t tick,
+                          std::function<void(Scheduler&)> control,
+                          const TaskGroups *groups = nullptr,
+                          const TaskBursts *bursts = nullptr) {
+  std::ostringstream os;
+  TextSink sink(os);
+  TaskListSource tasks(task_list, groups, bursts);
+  Scheduler cfs(tasks, sink);
+  do {
+    if (cfs.getTicks() == tick)
+      control(cfs);
+    cfs.appendTimeline();
+    cfs.moveNextTask();
+    cfs.getNextTask();
+    cfs.incrementTask();
+    cfs.printStatus();
+    cfs.purgeCompletion();
+    cfs.incrementTick();
+  } while (!cfs.done());
+  sink.Flush();
+  return os.str();
+}
+
+// 31) Check a waiting & a running task can be cancelled once
+TEST(Control, Cancel) {
+  std::vector<Task> task_list{Task('A', 0, 6), Task('B', 0, 6),
+                              Task('C', 0, 6)};
+  // C runs ticks 2-3, then A & B wait at min_vruntime
+  std::string output = runControlled(task_list, 4, [](Scheduler& cfs) {
+    TaskHandle b = cfs.findTask('B');
+    EXPECT_TRUE(cfs.cancelTask(b));
+    EXPECT_FALSE(cfs.cancelTask(b));
+    EXPECT_TRUE(cfs.findTask('B').isNull());
+    EXPECT_TRUE(cfs.cancelTask(cfs.findTask('C')));
+    EXPECT_EQ(cfs.getCancelled(), 2u);
+  });
+  EXPECT_EQ(output.substr(output.find("4 ")),
+    "4 [1]: A\n"
+    "5 [1]: A\n"
+    "6 [1]: A\n"
+    "7 [1]: A\n"
+    "8 [1]: A*\n");
+}
+
+// 32) Check a reniced task keeps the CPU time it is owed & then gets
+//     the share of its new weight
+TEST(Control, Renice) {
+  std::vector<Task> task_list{Task('A', 0, 400), Task('B', 0, 400)};
+  std::string output = runControlled(task_list, 100, [](Scheduler& cfs) {
+    EXPECT_THROW(cfs.reniceTask(cfs.findTask('B'), 20), std::out_of_range);
+    EXPECT_TRUE(cfs.reniceTask(cfs.findTask('B'), -5));
+    EXPECT_FALSE(cfs.reniceTask(TaskHandle(), 0));
+  });
+  // Count B's ticks in the 200 ticks after the renice
+  std::istringstream lines(output);
+  std::string line;
+  int b_ticks = 0;
+  for (int tick = 0; tick < 300 && std::getline(lines, line); tick++)
+    if (tick >= 100 && line.find(": B") != std::string::npos)
+      b_ticks++;
+  // Weight 3121 against 1024 is a 75% share
+  EXPECT_NEAR(b_ticks, 150, 4);
+}
+
+// countTicks - return # of ticks in [@first, @last) of per-tick @output
+//              on which a task of @ids ran
+int countTicks(const std::string& output, const std::string& ids,
+               int first, int last) {
+  std::istringstream lines(output);
+  std::string line;
+  int ticks = 0;
+  for (int tick = 0; tick < last && std::getline(lines, line); tick++) {
+    std::size_t colon = line.find(": ");
+    if (tick >= first && ids.find(line[colon + 2]) != std::string::npos)
+      ticks++;
+  }
+  return ticks;
+}
+
+// 33) Check group paths are parsed after the nice level or in its place
+//     & interned with their ancestors
+TEST(Group, Loader) {
+  std::string text = "A 0 5 /web/api\nB 1 5 -3 /web\nC 2 5 /\nD 3 5 2\n";
+  TaskScanner scanner(text.data(), text.data() + text.size());
+  TaskRecord rec;
+  TaskGroups groups;
+  std::vector<uint32_t> ids;
+  while (scanner.Next(rec))
+    ids.push_back(groups.Intern(rec.group, rec.group_length));
+  EXPECT_EQ(rec.nice, 2);
+  EXPECT_EQ(rec.group_length, 0u);
+
+  ASSERT_EQ(ids.size(), 4u);
+  EXPECT_EQ(groups.Size(), 3u);
+  EXPECT_EQ(groups.getPath(ids[0]), "/web/api");
+  EXPECT_EQ(ids[1], groups.getParent(ids[0]));
+  EXPECT_EQ(groups.getPath(ids[1]), "/web");
+  EXPECT_EQ(groups.getParent(ids[1]), 0u);
+  EXPECT_EQ(ids[2], 0u);
+  EXPECT_EQ(ids[3], 0u);
+}
+
+// 34) Check CPU time is shared fairly between groups first, then between
+//     the tasks of each group, at every level & with fast forward
+TEST(Group, Fairness) {
+  // /a holds one task, /b four; /c splits between /c/x & /c/y
+  std::string text = "A 0 900 /a\nB 0 900 /b\nC 0 900 /b\nD 0 900 /b\n"
+                     "E 0 900 /b\nF 0 900 /c/x\nG 0 900 /c/y\n"
+                     "H 0 900 /c/y\n";
+  std::string output = runStream(text);
+  EXPECT_NEAR(countTicks(output, "A", 0, 600), 200, 4);
+  EXPECT_NEAR(countTicks(output, "BCDE", 0, 600), 200, 4);
+  EXPECT_NEAR(countTicks(output, "B", 0, 600), 50, 4);
+  EXPECT_NEAR(countTicks(output, "F", 0, 600), 100, 4);
+  EXPECT_NEAR(countTicks(output, "G", 0, 600), 50, 4);
+  EXPECT_EQ(runStream(text, true), output);
+
+  // Loaded from a file, the run is the same
+  char file_name[] = "/tmp/test_groupsXXXXXX";
+  int fd = mkstemp(file_name);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  close(fd);
+  std::vector<Task> task_list;
+  TaskGroups groups;
+  loadTasks(task_list, file_name, &groups);
+  unlink(file_name);
+  organizeTasks(task_list);
+  std::ostringstream os;
+  TextSink sink(os);
+  TaskListSource tasks(task_list, &groups);
+  runCFS(tasks, sink);
+  EXPECT_EQ(os.str(), output);
+}
+
+// 35) Check a group leaves its parent's timeline with its last task &
+//     rejoins no earlier than the parent's min_vruntime
+TEST(Group, EmptyAndRejoin) {
+  TaskGroups groups;
+  uint32_t a = groups.Intern("/a", 2);
+  uint32_t b = groups.Intern("/b", 2);
+  uint32_t c = groups.Intern("/c", 2);
+  // /a idles from tick 5 to 100 while /b & /c share the CPU
+  std::vector<Task> task_list{Task('A', 0, 50, 0, a), Task('B', 0, 300, 0, b),
+                              Task('D', 0, 300, 0, c),
+                              Task('C', 100, 100, 0, a)};
+  std::string output = runControlled(task_list, 5, [](Scheduler& cfs) {
+    TaskHandle h = cfs.findTask('A');
+    EXPECT_TRUE(cfs.cancelTask(h));
+    EXPECT_FALSE(cfs.cancelTask(h));
+  }, &groups);
+  EXPECT_EQ(countTicks(output, "BD", 5, 100), 95);
+  // C is not owed the time /a spent idle, the three groups split the CPU
+  EXPECT_NEAR(countTicks(output, "C", 100, 190), 30, 2);
+  // The CPU never idles with a group left holding tasks
+  EXPECT_EQ(output.find(": _"), std::string::npos);
+}
+
+// WheelItem - object linked into a TimerWheel through its own fields
+struct WheelItem {
+  TimerLinks<WheelItem*> links;
+  uint64_t expires;
+};
+
+// WheelItemTraits - gives the wheel the links of a WheelItem
+struct WheelItemTraits {
+  typedef WheelItem* Ref;
+
+  TimerLinks<WheelItem*>& Links(WheelItem *n) {
+    return n->links;
+  }
+};
+
+// 36) Check the timer wheel fires each object once on its tick, across
+//     cascades & jumps over idle stretches, against a std::set
+TEST(TimerWheel, RandomAgainstStd) {
+  std::mt19937_64 rng(36);
+  std::vector<WheelItem> items(500);
+  TimerWheel<WheelItemTraits> wheel;
+  std::set<std::pair<uint64_t, WheelItem*>> armed;
+  // First tick not expired yet
+  uint64_t now = 0;
+  for (int round = 0; round < 50000; round++) {
+    WheelItem *n = &items[rng() % items.size()];
+    // Delays reach every level, mostly the lowest ones
+    uint64_t delay = rng() >> (20 + rng() % 44);
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        if (!wheel.Armed(n)) {
+          n->expires = now + delay;
+          wheel.Schedule(n, n->expires);
+          armed.insert({n->expires, n});
+        }
+        break;
+      case 2:
+        if (wheel.Armed(n)) {
+          wheel.Cancel(n);
+          armed.erase({n->expires, n});
+        }
+        break;
+      default:
+        uint64_t next;
+        ASSERT_EQ(wheel.NextEvent(&next), !armed.empty());
+        if (!armed.empty()) {
+          ASSERT_LE(next, armed.begin()->first);
+        }
+        uint64_t last = now;
+        wheel.Expire(now + delay, [&](WheelItem *f) {
+          ASSERT_GE(f->expires, last);
+          ASSERT_LE(f->expires, now + delay);
+          ASSERT_EQ(armed.erase({f->expires, f}), 1u);
+          last = f->expires;
+        });
+        now += delay + 1;
+        if (!armed.empty()) {
+          ASSERT_GE(armed.begin()->first, now);
+        }
+    }
+    ASSERT_EQ(wheel.Size(), armed.size());
+  }
+}
+
+// 37) Check bursts & sleeps are parsed in place of the duration, which
+//     becomes their total CPU time
+TEST(Sleep, Loader) {
+  std::string text = "A 0 2:5:3 1 /g\nB 1 4\n";
+  TaskScanner scanner(text.data(), text.data() + text.size());
+  TaskRecord rec;
+  TaskBursts bursts;
+  ASSERT_TRUE(scanner.Next(rec));
+  EXPECT_EQ(rec.duration, 5u);
+  EXPECT_EQ(rec.nice, 1);
+  EXPECT_EQ(rec.group_length, 2u);
+  uint64_t b = bursts.Intern(rec.bursts, rec.bursts_length);
+  EXPECT_TRUE(b != TaskBursts::kNone);
+  EXPECT_EQ(bursts.getTicks(b), 2u);
+  EXPECT_EQ(bursts.getTicks(b + 1), 5u);
+  EXPECT_EQ(bursts.getTicks(b + 2), 3u);
+  EXPECT_EQ(bursts.Size(), 3u);
+  ASSERT_TRUE(scanner.Next(rec));
+  EXPECT_EQ(rec.duration, 4u);
+  EXPECT_EQ(rec.bursts, nullptr);
+}
+
+// 38) Check a task leaves the timeline for each sleep & runs again on
+//     the tick after it, the same with fast forward, streamed or loaded
+TEST(Sleep, Bursts) {
+  std::string text = "A 0 6\nB 0 2:5:2:3:2\n";
+  std::string output = runStream(text);
+  EXPECT_EQ(output,
+    "0 [2]: A\n"
+    "1 [2]: B\n"
+    "2 [2]: B\n"
+    "3 [1]: A\n"
+    "4 [1]: A\n"
+    "5 [1]: A\n"
+    "6 [1]: A\n"
+    "7 [1]: A*\n"
+    "8 [1]: B\n"
+    "9 [1]: B\n"
+    "10 [0]: _\n"
+    "11 [0]: _\n"
+    "12 [0]: _\n"
+    "13 [1]: B\n"
+    "14 [1]: B*\n");
+  EXPECT_EQ(runStream(text, true), output);
+
+  char file_name[] = "/tmp/test_burstsXXXXXX";
+  int fd = mkstemp(file_name);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, text.data(), text.size()),
+            static_cast<ssize_t>(text.size()));
+  close(fd);
+  std::ostringstream os;
+  RunOptions options;
+  runTaskFile(file_name, os, options);
+  EXPECT_EQ(os.str(), output);
+  // Loaded without a TaskBursts, B runs its bursts back to back
+  std::vector<Task> task_list;
+  loadTasks(task_list, file_name);
+  unlink(file_name);
+  organizeTasks(task_list);
+  EXPECT_EQ(task_list[1].getDuration(), 6u);
+  EXPECT_TRUE(task_list[1].getBursts() == TaskBursts::kNone);
+}
+
+// 39) Check a waking sleeper is placed no earlier than kSleeperCredit
+//     before the running task & its wait excludes the time it slept
+TEST(Sleep, WakeupPlacement) {
+  TaskBursts bursts;
+  uint64_t b = bursts.Intern("1:10:8", 6);
+  std::vector<Task> task_list{Task('A', 0, 30),
+                              Task('B', 0, 9, 0, TaskGroups::kRoot, b)};
+  std::ostringstream os;
+  TextSink sink(os);
+  LatencyStats latency(os);
+  TaskListSource tasks(task_list, nullptr, &bursts);
+  runCFS(tasks, sink, false, &latency);
+  sink.Flush();
+  // B wakes on tick 12 ten ticks behind A; owed only the credit, it
+  // shares the CPU after a short head start instead of running its
+  // whole burst
+  int head_start = countTicks(os.str(), "B", 12, 20);
+  EXPECT_GE(head_start, 3);
+  EXPECT_LT(head_start, 8);
+  EXPECT_EQ(countTicks(os.str(), "B", 0, 39), 9);
+  // A waits 9 ticks, B 6 more than its 10 asleep
+  EXPECT_EQ(latency.getWait().Max(), 9u);
+  EXPECT_EQ(latency.getWait().Count(), 2u);
+  EXPECT_EQ(latency.getTurnaround().Max(), 39u);
+}
+
+// 40) Check sleeping & staged tasks can be cancelled off the wheel
+TEST(Sleep, Cancel) {
+  TaskBursts bursts;
+  uint64_t b = bursts.Intern("2:10:2", 6);
+  std::vector<Task> task_list{Task('A', 0, 4, 0, TaskGroups::kRoot, b),
+                              Task('B', 0, 20), Task('C', 50, 5)};
+  std::string output = runControlled(task_list, 5, [](Scheduler& cfs) {
+    // A sleeps until tick 13, C waits to arrive on tick 50
+    for (char id : {'A', 'C'}) {
+      TaskHandle h = cfs.findTask(id);
+      EXPECT_TRUE(cfs.reniceTask(h, 5));
+      EXPECT_TRUE(cfs.cancelTask(h));
+      EXPECT_FALSE(cfs.cancelTask(h));
+    }
+  }, nullptr, &bursts);
+  EXPECT_EQ(countTicks(output, "A", 0, 100), 2);
+  EXPECT_EQ(output.find('C'), std::string::npos);
+  // The run ends with B, nothing left on the wheel
+  EXPECT_EQ(output.substr(output.size() - 11), "21 [1]: B*\n");
+}
+
+// 41) Check a group whose task completes gives way to a sibling group
+//     due before it, rather than running its next task
+TEST(Group, CompletionSwitch) {
+  std::string text = "A 0 3 /a\nB 0 20 /a\nC 0 20 /b\n";
+  std::string output = runStream(text);
+  // A completes on tick 8 with /a 5 ticks in & /b 4, so C runs next
+  EXPECT_NE(output.find("\n8 [3]: A*\n9 [2]: C\n"), std::string::npos);
+  // /a gets no extra tick, the groups split the CPU evenly
+  EXPECT_EQ(countTicks(output, "AB", 0, 38), 19);
+  EXPECT_EQ(runStream(text, true), output);
+}
+
+// 42) Check --top lists a sleeper woken behind min_vruntime with a
+//     negative lag
+TEST(Sleep, TopReportLag) {
+  TaskBursts bursts;
+  uint64_t b = bursts.Intern("1:10:8", 6);
+  std::vector<Task> task_list{Task('A', 0, 30),
+                              Task('B', 0, 9, 0, TaskGroups::kRoot, b)};
+  NullSink sink;
+  std::ostringstream report;
+  LatencyStats latency(report, 1);
+  TaskListSource tasks(task_list, nullptr, &bursts);
+  runCFS(tasks, sink, false, &latency, 3);
+  // B is placed the sleeper credit, 3 ticks, before min_vruntime
+  EXPECT_NE(report.str().find("timeline at tick 13: running A waiting 1\n"
+                              "  B lag -3 remaining 8 nice 0\n"),
+            std::string::npos);
+}
+
+// 43) Check a handle stays stale however often its slot is recycled,
+//     past the 8-bit generation
+TEST(Pool, StaleHandles) {
+  TaskPool pool;
+  TaskHandle first = pool.Admit('A', 1, 0, 0);
+  TaskHandle h = first;
+  for (int i = 0; i < 256; i++) {
+    pool.Release(h);
+    h = pool.Admit('A', 1, 0, 0);
+    ASSERT_FALSE(pool.Valid(first));
+    ASSERT_NE(h, first);
+  }
+  EXPECT_THROW(pool.Check(first), std::logic_error);
+  EXPECT_EQ(pool.Find('A'), h);
+  EXPECT_EQ(pool.Size(), 1u);
+}
+
+// 44) Check several CPUs reject grouped & sleeping tasks, whether named
+//     up front or only as they arrive, rather than running them flat
+TEST(SMP, RejectsGroupsAndBursts) {
+  RunOptions options;
+  options.cpus = 2;
+  for (std::string text : {"A 0 5\nB 0 5 /a\n", "A 0 5 /b\n",
+                           "A 0 5\nB 0 2:3:3\n"}) {
+    char file_name[] = "/tmp/test_smpXXXXXX";
+    int fd = mkstemp(file_name);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, text.data(), text.size()),
+              static_cast<ssize_t>(text.size()));
+    close(fd);
+    std::ostringstream os;
+    EXPECT_THROW(runTaskFile(file_name, os, options), std::invalid_argument);
+    unlink(file_name);
+  }
+
+  // A source naming neither, as a stream before reading the task
+  TaskGroups groups;
+  TaskBursts bursts;
+  uint32_t a = groups.Intern("/a", 2);
+  uint64_t b = bursts.Intern("2:3:3", 5);
+  std::ostringstream os;
+  std::vector<Task> grouped{Task('A', 0, 5), Task('B', 3, 5, 0, a)};
+  TaskListSource grouped_tasks(grouped);
+  EXPECT_THROW(runSMP(grouped_tasks, 2, os), std::invalid_argument);
+  std::vector<Task> sleeping{Task('A', 0, 5),
+                             Task('B', 3, 5, 0, TaskGroups::kRoot, b)};
+  TaskListSource sleeping_tasks(sleeping);
+  EXPECT_THROW(runSMP(sleeping_tasks, 2, os), std::invalid_argument);
+}
+
+// 45) Check CPUs with nothing waiting run their tasks in one step, so
+//     long tasks on mostly idle CPUs take time independent of duration
+TEST(SMP, SparseLongTasks) {
+  std::vector<Task> task_list{Task('A', 0, 3000000000u),
+                              Task('B', 5, 2000000000u),
+                              Task('C', 7, 4)};
+  organizeTasks(task_list);
+  TaskListSource tasks(task_list);
+  std::ostringstream os;
+  runSMP(tasks, 256, os);
+  std::string summary = os.str();
+  EXPECT_EQ(summary.substr(0, summary.find('\n')), "ticks: 3000000000");
+  EXPECT_NE(summary.find("cpu 0: busy 3000000000 (100.0%)"),
+            std::string::npos);
+  EXPECT_NE(summary.find("cpu 1: busy 2000000000 (66.7%)"),
+            std::string::npos);
+  EXPECT_NE(summary.find("cpu 2: busy 4 (0.0%)"), std::string::npos);
+  EXPECT_NE(summary.find("total: busy 5000000004 (0.7%) migrations 0"),
+            std::string::npos);
+}
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
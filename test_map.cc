@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <vector>
+#include <utility>
 
 #include "map.h"
 
@@ -34,6 +36,83 @@ TEST(Map, MultipleKeys) {
   }
 }
 
+// Test pooled node allocation
+TEST(Map, PoolAllocator) {
+  Map<int, int, PoolAllocator> map;
+
+  for (int i = 0; i < 5000; i++) {
+    map.Insert(i, i * 2);
+  }
+  for (int i = 0; i < 5000; i += 2) {
+    map.Remove(i);
+  }
+
+  EXPECT_EQ(map.Size(), 2500);
+  EXPECT_EQ(map.Contains(42), false);
+  EXPECT_EQ(map.Get(43), 86);
+  EXPECT_EQ(map.Min(), 1);
+  EXPECT_EQ(map.Max(), 4999);
+
+  // Removing the min key refreshes the cached min node
+  map.Remove(1);
+  map.Remove(3);
+  EXPECT_EQ(map.Min(), 5);
+
+  map.Clear();
+  EXPECT_EQ(map.Size(), 0);
+  EXPECT_EQ(map.Contains(43), false);
+}
+
+// Test rotation bounds on insert & remove
+TEST(Map, RotationBounds) {
+  Map<int, int, HeapAllocator, CountingTreeStats> map;
+  std::vector<int> keys;
+  for (int i = 0; i < 2000; i++) {
+    keys.push_back(i);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+
+  for (auto i : keys) {
+    uint64_t rotations = map.GetStats().Rotations();
+    map.Insert(i, i);
+    EXPECT_LE(map.GetStats().Rotations() - rotations, 2u);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto i : keys) {
+    uint64_t rotations = map.GetStats().Rotations();
+    map.Remove(i);
+    EXPECT_LE(map.GetStats().Rotations() - rotations, 3u);
+    EXPECT_EQ(map.Contains(i), false);
+  }
+  EXPECT_EQ(map.Size(), 0);
+}
+
+// Test bulk load of sorted unique keys
+TEST(Map, BulkLoad) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < 2000; i++) {
+    pairs.push_back(std::make_pair(i * 2, i));
+  }
+  Map<int, int> map(pairs.begin(), pairs.end());
+  EXPECT_EQ(map.Size(), 2000);
+  EXPECT_EQ(map.Min(), 0);
+  EXPECT_EQ(map.Max(), 3998);
+  EXPECT_EQ(map.Get(1000), 500);
+  EXPECT_EQ(map.Contains(1001), false);
+
+  // Duplicate keys are rejected
+  pairs[5].first = pairs[4].first;
+  EXPECT_THROW(map.BulkLoad(pairs.begin(), pairs.end()), std::exception);
+  EXPECT_EQ(map.Size(), 2000);
+
+  for (int i = 0; i < 2000; i++) {
+    map.Insert(i * 2 + 1, i);
+    map.Remove(i * 2);
+  }
+  EXPECT_EQ(map.Size(), 2000);
+  EXPECT_EQ(map.Min(), 1);
+}
+
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
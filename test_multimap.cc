@@ -3,12 +3,18 @@
 // 917006087
 // ECS 36C - 05/22/2020
 //
-// test_multimap.cc - Unit tester for multimap.h
+// test_multimap.cc - Unit tester for multimap.h & intrusive_tree.h
 //
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <utility>
 #include <vector>
 
+#include "intrusive_tree.h"
 #include "multimap.h"
 
 // 1) Check one key: insert, contains, get
@@ -358,6 +364,460 @@ TEST(Multimap, RepInsertRemoval) {
   EXPECT_EQ(multimap.Contains(12), false);
 }
 
+// 11) Check pooled node allocation: insert, remove, clear, size, get
+TEST(Multimap, PoolAllocator) {
+  Multimap<int, int, PoolAllocator> multimap;
+
+  // Insert & remove enough keys to span several slabs
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 3000; i++) {
+      multimap.Insert(i % 1500, i);
+    }
+    EXPECT_EQ(multimap.Size(), 3000);
+    EXPECT_EQ(multimap.Min(), 0);
+    EXPECT_EQ(multimap.Max(), 1499);
+    EXPECT_EQ(multimap.Get(7), 7);
+
+    // Free nodes are recycled by the next insertions
+    for (int i = 0; i < 1500; i++) {
+      multimap.Remove(i);
+    }
+    EXPECT_EQ(multimap.Size(), 1500);
+    EXPECT_EQ(multimap.Get(7), 1507);
+    multimap.Clear();
+  }
+
+  // Check size & get exception after clear
+  EXPECT_EQ(multimap.Size(), 0);
+  EXPECT_THROW(multimap.Get(7), std::exception);
+}
+
+// 12) Check FIFO order across inline & spilled values: insert, remove, get
+TEST(Multimap, InlineValuesFifo) {
+  Multimap<int, int, HeapAllocator, 2> multimap;
+  std::vector<int> keys{40, 20, 60, 10, 30, 50, 70};
+
+  // Interleave pushes & pops so the ring wraps before & after spilling
+  for (auto i : keys) {
+    multimap.Insert(i, i);
+    multimap.Insert(i, i + 1);
+    multimap.Remove(i);
+    multimap.Insert(i, i + 2);
+    multimap.Insert(i, i + 3);
+  }
+  EXPECT_EQ(multimap.Size(), 21);
+
+  // Values of each key come out in insertion order; the last round
+  // deletes inner nodes first, which must leave the other keys' values
+  // attached to them
+  for (int v = 1; v <= 3; v++) {
+    for (auto i : keys) {
+      EXPECT_EQ(multimap.Get(i), i + v);
+      multimap.Remove(i);
+    }
+  }
+  EXPECT_EQ(multimap.Size(), 0);
+}
+
+// 13) Check popping minimum values: insert, popmin, size, min
+TEST(Multimap, PopMin) {
+  Multimap<int, int> multimap;
+  std::vector<int> keys{35, 15, 55, 5, 25, 45, 65};
+  int next_min = -1;
+
+  // Insert duplicates for the two smallest keys only
+  for (auto i : keys) {
+    multimap.Insert(i, i);
+  }
+  multimap.Insert(5, 6);
+  multimap.Insert(15, 16);
+
+  // Duplicates come out FIFO & keep min key in place
+  EXPECT_EQ(multimap.PopMin(&next_min), 5);
+  EXPECT_EQ(next_min, 5);
+  EXPECT_EQ(multimap.PopMin(&next_min), 6);
+  EXPECT_EQ(next_min, 15);
+  EXPECT_EQ(multimap.PopMin(&next_min), 15);
+  EXPECT_EQ(multimap.PopMin(&next_min), 16);
+  EXPECT_EQ(next_min, 25);
+  EXPECT_EQ(multimap.Size(), 5);
+
+  // Drain the rest in key order
+  for (int i = 25; i <= 65; i += 10) {
+    EXPECT_EQ(multimap.Min(), i);
+    EXPECT_EQ(multimap.PopMin(&next_min), i);
+    if (i < 65) {
+      EXPECT_EQ(next_min, i + 10);
+    }
+  }
+
+  // Check size & popmin exception
+  EXPECT_EQ(multimap.Size(), 0);
+  EXPECT_THROW(multimap.PopMin(), std::exception);
+}
+
+// 14) Check cached minimum through every update path: insert, remove,
+//     popmin, front, min
+TEST(Multimap, CachedMin) {
+  Multimap<int, int> multimap;
+  std::vector<int> keys{50, 30, 70, 20, 40, 60, 80, 10};
+
+  // Check front exception
+  EXPECT_THROW(multimap.Front(), std::exception);
+
+  // Each new smaller key takes over the minimum
+  for (auto i : keys) {
+    multimap.Insert(i, i);
+  }
+  multimap.Insert(10, 11);
+  EXPECT_EQ(multimap.Min(), 10);
+  EXPECT_EQ(multimap.Front(), 10);
+
+  // Removing a duplicate keeps the same min node
+  multimap.Remove(10);
+  EXPECT_EQ(multimap.Min(), 10);
+  EXPECT_EQ(multimap.Front(), 11);
+
+  // Removing the min node or an inner node refreshes the cache
+  multimap.Remove(10);
+  EXPECT_EQ(multimap.Min(), 20);
+  multimap.Remove(50);
+  multimap.Remove(20);
+  EXPECT_EQ(multimap.Min(), 30);
+  EXPECT_EQ(multimap.PopMin(), 30);
+  EXPECT_EQ(multimap.Min(), 40);
+  EXPECT_EQ(multimap.Front(), 40);
+
+  // Check front exception after clear
+  multimap.Clear();
+  EXPECT_THROW(multimap.Front(), std::exception);
+  multimap.Insert(5, 5);
+  EXPECT_EQ(multimap.Min(), 5);
+}
+
+// 15) Check random insert/remove/popmin against std::multimap, with at
+//     most 2 rotations per insert & 3 per removal
+TEST(Multimap, RandomAgainstStd) {
+  Multimap<int, int, HeapAllocator, 1, CountingTreeStats> multimap;
+  std::multimap<int, int> expected;
+  unsigned int seed = 12345;
+
+  for (int step = 0; step < 20000; step++) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % 500;
+    uint64_t rotations = multimap.GetStats().Rotations();
+
+    // Insert half of the time, otherwise remove or pop the minimum
+    if (step % 2 == 0 || expected.empty()) {
+      multimap.Insert(key, step);
+      expected.insert(std::make_pair(key, step));
+      EXPECT_LE(multimap.GetStats().Rotations() - rotations, 2u);
+    } else if (step % 3 == 0) {
+      EXPECT_EQ(multimap.PopMin(), expected.begin()->second);
+      expected.erase(expected.begin());
+      EXPECT_LE(multimap.GetStats().Rotations() - rotations, 3u);
+    } else {
+      auto it = expected.lower_bound(key);
+      if (it != expected.end() && it->first == key) {
+        EXPECT_EQ(multimap.Get(key), it->second);
+        expected.erase(it);
+      }
+      multimap.Remove(key);
+      EXPECT_LE(multimap.GetStats().Rotations() - rotations, 3u);
+    }
+
+    // Check size, min & max agree
+    ASSERT_EQ(multimap.Size(), expected.size());
+    if (!expected.empty()) {
+      EXPECT_EQ(multimap.Min(), expected.begin()->first);
+      EXPECT_EQ(multimap.Max(), expected.rbegin()->first);
+    }
+  }
+}
+
+// 16) Check counters of the stats policy; the default policy adds nothing
+TEST(Multimap, TreeStats) {
+  Multimap<int, int, HeapAllocator, 1, CountingTreeStats> multimap;
+  EXPECT_LT(sizeof(Multimap<int, int>), sizeof(multimap));
+
+  // Ascending keys force a rotation & recoloring on most inserts
+  for (int i = 0; i < 1023; i++)
+    multimap.Insert(i, i);
+  multimap.Insert(0, 0);
+  const CountingTreeStats &stats = multimap.GetStats();
+  EXPECT_EQ(stats.Inserts(), 1024u);
+  EXPECT_EQ(stats.Removes(), 0u);
+  EXPECT_GT(stats.Rotations(), 0u);
+  EXPECT_GT(stats.Recolors(), 0u);
+  // A red-black tree of 1023 keys is at most 2 * log2(1024) deep
+  EXPECT_GE(stats.MaxDepth(), 10u);
+  EXPECT_LE(stats.MaxDepth(), 20u);
+
+  // Each lookup visits at least the root
+  uint64_t visits = stats.Visits();
+  EXPECT_TRUE(multimap.Contains(512));
+  EXPECT_GE(stats.Visits(), visits + 1);
+  EXPECT_LE(stats.Visits(), visits + stats.MaxDepth());
+
+  // Removals of absent keys are not counted
+  multimap.Remove(5000);
+  multimap.Remove(512);
+  multimap.PopMin();
+  EXPECT_EQ(stats.Removes(), 2u);
+  EXPECT_EQ(multimap.Size(), 1022u);
+
+  std::ostringstream os;
+  stats.Print(os);
+  EXPECT_EQ(os.str().compare(0, 30, "tree: inserts 1024 removes 2 r"), 0);
+}
+
+// 17) Check bulk load of sorted pairs, duplicates grouped in input order
+TEST(Multimap, BulkLoad) {
+  std::vector<std::pair<int, int>> pairs;
+  std::multimap<int, int> expected;
+  for (int i = 0; i < 3000; i++) {
+    pairs.push_back(std::make_pair(i / 3, i));
+    expected.insert(pairs.back());
+  }
+  Multimap<int, int, HeapAllocator, 1, CountingTreeStats> multimap(
+    pairs.begin(), pairs.end());
+  EXPECT_EQ(multimap.Size(), 3000u);
+  EXPECT_EQ(multimap.Min(), 0);
+  EXPECT_EQ(multimap.Max(), 999);
+  EXPECT_EQ(multimap.Get(500), 1500);
+  EXPECT_EQ(multimap.GetStats().Rotations(), 0u);
+  // 1000 keys fill 10 levels
+  EXPECT_EQ(multimap.GetStats().MaxDepth(), 10u);
+
+  // An unsorted range is rejected & leaves the tree as it was
+  std::swap(pairs[10], pairs[2000]);
+  EXPECT_THROW(multimap.BulkLoad(pairs.begin(), pairs.end()),
+               std::exception);
+  EXPECT_EQ(multimap.Size(), 3000u);
+
+  // The loaded tree keeps balancing through ordinary updates
+  unsigned int seed = 777;
+  for (int step = 0; step < 6000; step++) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % 1500;
+    if (step % 2) {
+      multimap.Insert(key, step);
+      expected.insert(std::make_pair(key, step));
+    } else {
+      EXPECT_EQ(multimap.PopMin(), expected.begin()->second);
+      expected.erase(expected.begin());
+    }
+  }
+  ASSERT_EQ(multimap.Size(), expected.size());
+  for (auto &kv : expected)
+    EXPECT_EQ(multimap.PopMin(), kv.second);
+
+  // Loading an empty range empties the tree
+  multimap.Insert(1, 1);
+  multimap.BulkLoad(pairs.end(), pairs.end());
+  EXPECT_EQ(multimap.Size(), 0u);
+  EXPECT_THROW(multimap.Front(), std::exception);
+}
+
+// 18) Check iterators, bounds & ForEach against std::multimap
+TEST(Multimap, Iterators) {
+  Multimap<int, int> multimap;
+  std::multimap<int, int> expected;
+  EXPECT_TRUE(multimap.begin() == multimap.end());
+
+  unsigned int seed = 99;
+  for (int i = 0; i < 2000; i++) {
+    seed = seed * 1103515245 + 12345;
+    int key = static_cast<int>((seed >> 8) % 300) * 2;
+    multimap.Insert(key, i);
+    expected.insert(std::make_pair(key, i));
+  }
+
+  // Forward walk visits values of equal keys in insertion order
+  auto want = expected.begin();
+  for (auto it = multimap.begin(); it != multimap.end(); ++it, ++want) {
+    ASSERT_EQ(it.key(), want->first);
+    ASSERT_EQ(*it, want->second);
+  }
+  EXPECT_TRUE(want == expected.end());
+
+  // Backward walk from end()
+  auto rwant = expected.rbegin();
+  for (auto it = multimap.end(); it != multimap.begin(); ++rwant) {
+    --it;
+    ASSERT_EQ(it.key(), rwant->first);
+    ASSERT_EQ(*it, rwant->second);
+  }
+  EXPECT_TRUE(rwant == expected.rend());
+
+  // Bounds of present, absent & out of range keys
+  for (int key = -1; key <= 601; key++) {
+    auto lower = multimap.LowerBound(key);
+    auto upper = multimap.UpperBound(key);
+    if (expected.lower_bound(key) == expected.end())
+      EXPECT_TRUE(lower == multimap.end());
+    else
+      EXPECT_EQ(lower.key(), expected.lower_bound(key)->first);
+    if (expected.upper_bound(key) == expected.end())
+      EXPECT_TRUE(upper == multimap.end());
+    else
+      EXPECT_EQ(upper.key(), expected.upper_bound(key)->first);
+
+    auto range = multimap.EqualRange(key);
+    auto want_range = expected.equal_range(key);
+    EXPECT_TRUE(range.first == lower);
+    EXPECT_TRUE(range.second == upper);
+    for (auto it = range.first; it != range.second; ++it, ++want_range.first)
+      ASSERT_EQ(*it, want_range.first->second);
+    EXPECT_TRUE(want_range.first == want_range.second);
+  }
+
+  // Values of keys in [100, 200)
+  int in_range = 0;
+  for (auto it = multimap.LowerBound(100); it != multimap.LowerBound(200);
+       it++)
+    in_range++;
+  EXPECT_EQ(in_range, std::distance(expected.lower_bound(100),
+                                    expected.lower_bound(200)));
+
+  // ForEach sees every pair in order
+  want = expected.begin();
+  multimap.ForEach([&want](const int &key, const int &value) {
+    EXPECT_EQ(key, want->first);
+    EXPECT_EQ(value, want->second);
+    ++want;
+  });
+  EXPECT_TRUE(want == expected.end());
+
+  Multimap<int, int> small;
+  small.Insert(2, 20);
+  small.Insert(1, 10);
+  small.Insert(2, 21);
+  std::ostringstream os;
+  small.Print(os);
+  EXPECT_EQ(os.str(), "<1,10> <2,20> <2,21> \n");
+}
+
+// 19) Check removal of given (key, value) pairs against std::multimap
+TEST(Multimap, RemovePair) {
+  Multimap<int, int, HeapAllocator, 2> multimap;
+  std::multimap<int, int> expected;
+  EXPECT_FALSE(multimap.Remove(1, 1));
+
+  unsigned int seed = 4242;
+  for (int i = 0; i < 3000; i++) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % 100;
+    multimap.Insert(key, i);
+    expected.insert(std::make_pair(key, i));
+  }
+  for (int step = 0; step < 4000; step++) {
+    seed = seed * 1103515245 + 12345;
+    int key = (seed >> 8) % 102;
+    int value = (seed >> 4) % 3000;
+    // Usually remove a value that is there, sometimes one that is not
+    auto range = expected.equal_range(key);
+    auto it = range.first;
+    while (it != range.second && it->second != value)
+      ++it;
+    if (step % 2 && range.first != range.second) {
+      it = range.first;
+      std::advance(it, value % expected.count(key));
+      value = it->second;
+    }
+    bool present = it != range.second;
+    ASSERT_EQ(multimap.Remove(key, value), present);
+    if (present)
+      expected.erase(it);
+    ASSERT_EQ(multimap.Size(), expected.size());
+  }
+
+  // Remaining values keep their order under each key
+  auto want = expected.begin();
+  for (auto it = multimap.begin(); it != multimap.end(); ++it, ++want) {
+    ASSERT_EQ(it.key(), want->first);
+    ASSERT_EQ(*it, want->second);
+  }
+  if (!expected.empty()) {
+    EXPECT_EQ(multimap.Min(), expected.begin()->first);
+  }
+}
+
+// Object ordered by an IntrusiveTree through the links it embeds
+struct Item {
+  int key;
+  int value;
+  bool linked;
+  RbLinks<Item*> links;
+};
+
+// Gives an IntrusiveTree access to the links & keys of Items
+struct ItemTraits {
+  typedef Item* Ref;
+
+  RbLinks<Item*>& Links(Item *n) {
+    return n->links;
+  }
+
+  bool Less(Item *a, Item *b) {
+    return a->key < b->key;
+  }
+};
+
+// 20) Check intrusive linking & unlinking against std::multimap: order,
+//     equal keys first in first out, cached min & balanced depth
+TEST(IntrusiveTree, RandomAgainstStd) {
+  IntrusiveTree<ItemTraits, CountingTreeStats> tree;
+  std::multimap<int, int> expected;
+  std::vector<Item> items(2000);
+  EXPECT_TRUE(tree.Front() == nullptr);
+  EXPECT_THROW(tree.PopMin(), std::runtime_error);
+
+  unsigned int seed = 777;
+  for (int step = 0; step < 20000; step++) {
+    seed = seed * 1103515245 + 12345;
+    Item &item = items[(seed >> 8) % items.size()];
+    if (item.linked) {
+      // Unlink this very item, whatever its place among equal keys
+      tree.Remove(&item);
+      auto range = expected.equal_range(item.key);
+      auto it = range.first;
+      while (it->second != item.value)
+        ++it;
+      expected.erase(it);
+      item.linked = false;
+    } else {
+      item.key = (seed >> 4) % 50;
+      item.value = step;
+      item.linked = true;
+      tree.Insert(&item);
+      expected.insert(std::make_pair(item.key, item.value));
+    }
+    ASSERT_EQ(tree.Size(), expected.size());
+    if (!expected.empty()) {
+      ASSERT_EQ(tree.Front()->value, expected.begin()->second);
+    }
+  }
+
+  auto want = expected.begin();
+  for (Item *n = tree.Front(); n; n = tree.Next(n), ++want) {
+    ASSERT_EQ(n->key, want->first);
+    ASSERT_EQ(n->value, want->second);
+  }
+  EXPECT_TRUE(want == expected.end());
+  // Red-black depth bound of 2 * log2(n + 1), n being at most 2000
+  EXPECT_LE(tree.GetStats().MaxDepth(), 22u);
+
+  // Popping drains equal keys in the order they were linked
+  while (!expected.empty()) {
+    Item *n = tree.PopMin();
+    ASSERT_EQ(n->value, expected.begin()->second);
+    expected.erase(expected.begin());
+  }
+  EXPECT_EQ(tree.Size(), 0u);
+  EXPECT_EQ(tree.GetStats().Inserts(), tree.GetStats().Removes());
+}
+
 int main(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,287 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// timer_wheel.h - Hierarchical timing wheel whose link fields live inside
+// the objects it holds, as in intrusive_tree.h. Each level has 64 slots,
+// each slot spanning 64 times the ticks of one below; an object waits in
+// the lowest level its expiry tick is within reach of & moves down a
+// level (cascades) when the clock reaches the start of its slot, so
+// scheduling, cancelling & firing each take O(1) & no object is looked
+// at until it is due. A bitmap of occupied slots per level finds the
+// next tick with work, letting the clock jump over idle stretches.
+// Public API: Size, Armed, Schedule, Cancel, NextEvent, Expire
+// Helpers: Place, Link, Unlink, Detach, Process, FindNext
+//
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <cstdint>
+
+// TimerLinks - links an object embeds to wait in a TimerWheel; @Ref is
+//              how objects refer to each other, null when
+//              value-initialized, & value-initialized links are unarmed
+template <typename Ref>
+struct TimerLinks {
+  // Ring of the objects in the same slot, in the order they reached it
+  Ref next;
+  Ref prev;
+  // Tick the object fires on
+  uint64_t expires;
+  // 1 + index of the slot holding the object, 0 if not armed
+  uint16_t slot;
+};
+
+// @Traits gives the wheel access to the objects:
+//   typedef Ref - reference to an object, e.g. a pointer or index
+//   TimerLinks<Ref>& Links(Ref n) - links embedded in @n
+template <typename Traits>
+class TimerWheel {
+ public:
+  typedef typename Traits::Ref Ref;
+
+  // Bits of the tick indexing each level, & slots per level
+  static const unsigned int kSlotBits = 6;
+  static const unsigned int kSlots = 1 << kSlotBits;
+  // Enough levels to reach any 64-bit tick
+  static const unsigned int kLevels = (64 + kSlotBits - 1) / kSlotBits;
+
+  // TimerWheel() - clock starts at tick @start
+  explicit TimerWheel(Traits t = Traits(), uint64_t start = 0) :
+      traits(t), now(start) {}
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Return # of objects waiting
+  unsigned int Size();
+  // Return true if @n is waiting
+  bool Armed(Ref n);
+  // Make @n, not waiting, fire on tick @expires, or on the next tick
+  // expired if @expires has already passed
+  void Schedule(Ref n, uint64_t expires);
+  // Take waiting @n off the wheel without firing it
+  void Cancel(Ref n);
+  // Store the earliest tick the wheel may have work on in @tick; return
+  // false if empty
+  bool NextEvent(uint64_t *tick);
+  // Fire every object due on or before @tick through @fire(n), tick by
+  // tick, & move the clock past @tick; @fire may schedule objects
+  template <typename Fire>
+  void Expire(uint64_t tick, Fire fire);
+
+ private:
+  Traits traits;
+  // First object of each slot's ring, level by level
+  Ref heads[kLevels * kSlots] = {};
+  // Bit i of a level set if its slot i holds objects
+  uint64_t occupied[kLevels] = {};
+  // First tick not expired yet
+  uint64_t now;
+  // No object has work before this tick, while any wait
+  uint64_t next_event = 0;
+  unsigned int cur_size = 0;
+
+  // Links - return links of @n
+  TimerLinks<Ref>& Links(Ref n) {
+    return traits.Links(n);
+  }
+
+  // IsNull - return true for the null reference
+  static bool IsNull(Ref n) {
+    return n == Ref();
+  }
+
+  // Helper methods for placing & moving objects
+  void Place(Ref n, uint64_t expires);
+  void Link(Ref n, unsigned int slot);
+  void Unlink(Ref n);
+  Ref Detach(unsigned int slot);
+  template <typename Fire>
+  void Process(Fire& fire);
+  uint64_t FindNext();
+};
+
+// Size - return # of objects waiting
+template <typename Traits>
+unsigned int TimerWheel<Traits>::Size(void) {
+  return cur_size;
+}
+
+// Armed - return true if @n sits in a slot
+template <typename Traits>
+bool TimerWheel<Traits>::Armed(Ref n) {
+  return Links(n).slot != 0;
+}
+
+// Schedule - place @n by its expiry, clamped to the clock
+template <typename Traits>
+void TimerWheel<Traits>::Schedule(Ref n, uint64_t expires) {
+  if (expires < now)
+    expires = now;
+  // An empty wheel has no lower bound to keep
+  if (cur_size++ == 0)
+    next_event = ~uint64_t(0);
+  Place(n, expires);
+}
+
+// Cancel - unlink @n; the cached next event stays a valid lower bound
+template <typename Traits>
+void TimerWheel<Traits>::Cancel(Ref n) {
+  Unlink(n);
+  cur_size--;
+}
+
+// NextEvent - store lower bound on the next firing or cascade
+template <typename Traits>
+bool TimerWheel<Traits>::NextEvent(uint64_t *tick) {
+  if (!cur_size)
+    return false;
+  *tick = next_event;
+  return true;
+}
+
+// Expire - process only the ticks with work, jumping over the rest
+template <typename Traits>
+template <typename Fire>
+void TimerWheel<Traits>::Expire(uint64_t tick, Fire fire) {
+  while (cur_size && next_event <= tick) {
+    now = next_event;
+    Process(fire);
+    if (cur_size)
+      next_event = FindNext();
+  }
+  if (now <= tick)
+    now = tick + 1;
+}
+
+// Place - link @n into the lowest level that reaches @expires from the
+//         clock; level l holds objects 64^l to 64^(l+1) ticks away, in
+//         the slot of bits 6l & up of @expires, so each is reached
+//         exactly when the clock enters its slot
+template <typename Traits>
+void TimerWheel<Traits>::Place(Ref n, uint64_t expires) {
+  uint64_t delta = expires - now;
+  unsigned int level = delta ?
+    static_cast<unsigned int>(63 - __builtin_clzll(delta)) / kSlotBits : 0;
+  unsigned int shift = level * kSlotBits;
+  Links(n).expires = expires;
+  Link(n, level * kSlots +
+       static_cast<unsigned int>((expires >> shift) & (kSlots - 1)));
+  // Tick the object fires on, or cascades on at the start of its slot
+  uint64_t event = expires >> shift << shift;
+  if (event < next_event)
+    next_event = event;
+}
+
+// Link - append @n to the ring of @slot
+template <typename Traits>
+void TimerWheel<Traits>::Link(Ref n, unsigned int slot) {
+  Ref head = heads[slot];
+  Links(n).slot = static_cast<uint16_t>(slot + 1);
+  if (IsNull(head)) {
+    heads[slot] = n;
+    Links(n).next = n;
+    Links(n).prev = n;
+    occupied[slot / kSlots] |= uint64_t(1) << (slot % kSlots);
+    return;
+  }
+  Ref tail = Links(head).prev;
+  Links(n).prev = tail;
+  Links(n).next = head;
+  Links(tail).next = n;
+  Links(head).prev = n;
+}
+
+// Unlink - take @n out of its slot's ring
+template <typename Traits>
+void TimerWheel<Traits>::Unlink(Ref n) {
+  unsigned int slot = Links(n).slot - 1u;
+  Links(n).slot = 0;
+  // Last object of the slot
+  if (Links(n).next == n) {
+    heads[slot] = Ref();
+    occupied[slot / kSlots] &= ~(uint64_t(1) << (slot % kSlots));
+    return;
+  }
+  Ref nxt = Links(n).next;
+  Ref prv = Links(n).prev;
+  Links(prv).next = nxt;
+  Links(nxt).prev = prv;
+  if (heads[slot] == n)
+    heads[slot] = nxt;
+}
+
+// Detach - empty @slot & return the first object of its ring, null if
+//          none; the ring stays linked for the caller to walk
+template <typename Traits>
+typename TimerWheel<Traits>::Ref TimerWheel<Traits>::Detach(
+    unsigned int slot) {
+  Ref head = heads[slot];
+  heads[slot] = Ref();
+  occupied[slot / kSlots] &= ~(uint64_t(1) << (slot % kSlots));
+  return head;
+}
+
+// Process - expire the clock's tick: cascade every level whose slot
+//           starts on it, lowest first, then fire its level 0 slot
+template <typename Traits>
+template <typename Fire>
+void TimerWheel<Traits>::Process(Fire& fire) {
+  for (unsigned int level = 1; level < kLevels; level++) {
+    unsigned int shift = level * kSlotBits;
+    if (now & ((uint64_t(1) << shift) - 1))
+      break;
+    Ref first = Detach(level * kSlots +
+                       static_cast<unsigned int>((now >> shift) &
+                                                 (kSlots - 1)));
+    if (IsNull(first))
+      continue;
+    // Each object lands below, closer to the clock
+    Ref n = first;
+    do {
+      Ref nxt = Links(n).next;
+      Place(n, Links(n).expires);
+      n = nxt;
+    } while (n != first);
+  }
+  Ref first = Detach(static_cast<unsigned int>(now & (kSlots - 1)));
+  now++;
+  if (IsNull(first))
+    return;
+  Ref n = first;
+  do {
+    Ref nxt = Links(n).next;
+    Links(n).slot = 0;
+    cur_size--;
+    fire(n);
+    n = nxt;
+  } while (n != first);
+}
+
+// FindNext - return the earliest tick from the clock on which an
+//            occupied slot fires or cascades
+template <typename Traits>
+uint64_t TimerWheel<Traits>::FindNext(void) {
+  uint64_t best = ~uint64_t(0);
+  for (unsigned int level = 0; level < kLevels; level++) {
+    if (!occupied[level])
+      continue;
+    unsigned int shift = level * kSlotBits;
+    // First slot starting at or after the clock, then the next occupied
+    // one around the ring from it
+    uint64_t base = (now >> shift) +
+      ((now & ((uint64_t(1) << shift) - 1)) ? 1 : 0);
+    unsigned int r = static_cast<unsigned int>(base & (kSlots - 1));
+    uint64_t bits = r ? occupied[level] >> r | occupied[level] << (64 - r) :
+      occupied[level];
+    uint64_t event = (base + static_cast<unsigned int>(__builtin_ctzll(bits)))
+      << shift;
+    if (event < best)
+      best = event;
+  }
+  return best;
+}
+
+#endif  // TIMER_WHEEL_H_
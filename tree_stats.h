@@ -0,0 +1,112 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// tree_stats.h - Instrumentation policies for the Map & Multimap trees
+// NoTreeStats: every hook is empty & inlined away (default behavior)
+// CountingTreeStats: counts operations, rotations, recolored nodes &
+//                    nodes visited, & tracks the deepest node reached
+//
+
+#ifndef TREE_STATS_H_
+#define TREE_STATS_H_
+
+#include <cstdint>
+#include <iostream>
+
+// NoTreeStats - keep no statistics
+class NoTreeStats {
+ public:
+  void OnInsert(void) {}
+  void OnRemove(void) {}
+  void OnRotate(void) {}
+  void OnRecolor(unsigned int) {}
+  void OnVisit(void) {}
+  void OnDepth(unsigned int) {}
+
+  // Print - nothing to print
+  void Print(std::ostream&) const {}
+};
+
+// CountingTreeStats - count every hook the tree calls
+class CountingTreeStats {
+ public:
+  // OnInsert - a value was inserted
+  void OnInsert(void) {
+    inserts++;
+  }
+
+  // OnRemove - a value was removed
+  void OnRemove(void) {
+    removes++;
+  }
+
+  // OnRotate - a left or right rotation was performed
+  void OnRotate(void) {
+    rotations++;
+  }
+
+  // OnRecolor - @n nodes had their color set while rebalancing
+  void OnRecolor(unsigned int n) {
+    recolors += n;
+  }
+
+  // OnVisit - a node was examined while walking the tree
+  void OnVisit(void) {
+    visits++;
+  }
+
+  // OnDepth - a walk reached a node at @depth, the root being 1
+  void OnDepth(unsigned int depth) {
+    if (depth > max_depth)
+      max_depth = depth;
+  }
+
+  // Inserts - return # of values inserted
+  uint64_t Inserts(void) const {
+    return inserts;
+  }
+
+  // Removes - return # of values removed
+  uint64_t Removes(void) const {
+    return removes;
+  }
+
+  // Rotations - return # of rotations performed
+  uint64_t Rotations(void) const {
+    return rotations;
+  }
+
+  // Recolors - return # of nodes recolored while rebalancing
+  uint64_t Recolors(void) const {
+    return recolors;
+  }
+
+  // Visits - return # of nodes examined by walks
+  uint64_t Visits(void) const {
+    return visits;
+  }
+
+  // MaxDepth - return depth of the deepest node any walk reached
+  unsigned int MaxDepth(void) const {
+    return max_depth;
+  }
+
+  // Print - write every counter on one line
+  void Print(std::ostream& os) const {
+    os << "tree: inserts " << inserts << " removes " << removes <<
+      " rotations " << rotations << " recolors " << recolors <<
+      " visits " << visits << " max_depth " << max_depth << '\n';
+  }
+
+ private:
+  uint64_t inserts = 0;
+  uint64_t removes = 0;
+  uint64_t rotations = 0;
+  uint64_t recolors = 0;
+  uint64_t visits = 0;
+  unsigned int max_depth = 0;
+};
+
+#endif  // TREE_STATS_H_
@@ -0,0 +1,59 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// vruntime.h - Virtual runtime as a 64-bit counter of 32.32 fixed point
+// ticks, ordered the way the Linux kernel orders it, by the sign of the
+// difference between two values. The counter wraps every 2^32 ticks of
+// vruntime without disturbing the order of runnable tasks, as long as
+// they are less than 2^31 ticks apart.
+//
+
+#ifndef VRUNTIME_H_
+#define VRUNTIME_H_
+
+#include <cstdint>
+#include <iostream>
+
+// min_vruntime of a new timeline; as in the kernel, it starts just below
+// the wrap point, 2^20 ticks short of it, so long runs cross it early
+const uint64_t kInitialVRuntime = static_cast<uint64_t>(-(int64_t(1) << 52));
+
+// Most vruntime a waking sleeper is placed before min_vruntime; as in the
+// kernel with GENTLE_FAIR_SLEEPERS, half of a 6 tick scheduling latency,
+// so sleeping earns a bounded head start rather than all the time slept
+const uint64_t kSleeperCredit = uint64_t(3) << 32;
+
+// vruntimeBefore - return true if @a comes before @b
+inline bool vruntimeBefore(uint64_t a, uint64_t b) {
+  return static_cast<int64_t>(a - b) < 0;
+}
+
+// VRuntime - timeline key ordered by vruntimeBefore
+class VRuntime {
+ public:
+    explicit VRuntime(uint64_t v = 0) : value(v) {}
+
+    // get - return the raw vruntime
+    uint64_t get(void) const {
+      return value;
+    }
+
+    friend bool operator<(const VRuntime& a, const VRuntime& b) {
+      return vruntimeBefore(a.value, b.value);
+    }
+
+    friend bool operator==(const VRuntime& a, const VRuntime& b) {
+      return a.value == b.value;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const VRuntime& v) {
+      return os << v.value;
+    }
+
+ private:
+    uint64_t value;
+};
+
+#endif  // VRUNTIME_H_
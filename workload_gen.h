@@ -0,0 +1,220 @@
+//
+// Karl Goeltner
+// 917006087
+// ECS 36C - 05/22/2020
+//
+// workload_gen.h - Synthetic task files drawn from seeded distributions.
+// WorkloadSpec: # of tasks, arrival process & duration distribution
+// WorkloadGenerator: yields tasks in start-time order from a 64-bit
+//                    Mersenne Twister; every draw is derived from raw
+//                    engine output, so a seed gives the same file on any
+//                    standard library
+// writeWorkload: task file lines in the loaders' format
+//
+
+#ifndef WORKLOAD_GEN_H_
+#define WORKLOAD_GEN_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "nice_weights.h"
+#include "status_sink.h"
+#include "task_loader.h"
+
+// Arrivals - how start times are spread
+enum class Arrivals {
+  // Independent arrivals, exponential gaps at the mean rate
+  kPoisson,
+  // Bursts at 16x the mean rate separated by idle gaps
+  kBursty,
+  // Groups of tasks sharing one start tick, evenly spaced
+  kBatch
+};
+
+// Durations - how durations are drawn
+enum class Durations {
+  // Uniform in [1, 2 * mean - 1]
+  kUniform,
+  // Pareto with shape 1.5: finite mean, unbounded variance
+  kHeavyTail,
+  // 80% short tasks around mean / 4 & 20% long ones around 4 * mean
+  kBimodal
+};
+
+// WorkloadSpec - parameters of a generated task file
+struct WorkloadSpec {
+  uint64_t tasks = 1000;
+  uint64_t seed = 1;
+  Arrivals arrivals = Arrivals::kPoisson;
+  // Mean # of arrivals per tick
+  double rate = 0.1;
+  // Mean # of tasks per burst, exact # per batch
+  uint64_t burst = 64;
+  Durations durations = Durations::kUniform;
+  uint64_t mean_duration = 10;
+  // Cap on any duration, 0 for 1000 * mean_duration
+  uint64_t max_duration = 0;
+  // Draw a nice level per task instead of leaving the column out
+  bool nice = false;
+};
+
+// parseArrivals - return the arrival process named @name
+inline Arrivals parseArrivals(const std::string& name) {
+  if (name == "poisson")
+    return Arrivals::kPoisson;
+  if (name == "bursty")
+    return Arrivals::kBursty;
+  if (name == "batch")
+    return Arrivals::kBatch;
+  throw std::invalid_argument("unknown arrivals " + name);
+}
+
+// parseDurations - return the duration distribution named @name
+inline Durations parseDurations(const std::string& name) {
+  if (name == "uniform")
+    return Durations::kUniform;
+  if (name == "heavy-tail")
+    return Durations::kHeavyTail;
+  if (name == "bimodal")
+    return Durations::kBimodal;
+  throw std::invalid_argument("unknown durations " + name);
+}
+
+// WorkloadGenerator - draws the tasks of a WorkloadSpec one at a time
+class WorkloadGenerator {
+ public:
+    // Arrival rate multiplier inside a burst
+    static const unsigned int kBurstSpeedup = 16;
+
+    // WorkloadGenerator() - generator for @spec; throws on a spec that
+    //                       cannot produce tasks
+    explicit WorkloadGenerator(const WorkloadSpec& workload) :
+        spec(workload), rng(workload.seed),
+        max_duration(workload.max_duration ? workload.max_duration :
+                     1000 * workload.mean_duration) {
+      if (!(spec.rate > 0) || spec.burst == 0 || spec.mean_duration == 0)
+        throw std::invalid_argument("rate, burst & mean duration must be "
+                                    "positive");
+    }
+
+    // Next - store the next task in @rec; return false once all
+    //        spec.tasks tasks were drawn
+    bool Next(TaskRecord& rec) {
+      if (drawn == spec.tasks)
+        return false;
+      rec.id = static_cast<char>('A' + drawn % 26);
+      rec.start_time = NextStart();
+      rec.duration = NextDuration();
+      rec.nice = spec.nice ? kMinNice + static_cast<int>(Below(kNiceLevels))
+                           : 0;
+      rec.group = nullptr;
+      rec.group_length = 0;
+      rec.bursts = nullptr;
+      rec.bursts_length = 0;
+      drawn++;
+      return true;
+    }
+
+ private:
+    const WorkloadSpec spec;
+    std::mt19937_64 rng;
+    uint64_t max_duration;
+    uint64_t drawn = 0;
+    // Arrival clock in fractional ticks
+    double clock = 0;
+    // Tasks left in the current burst
+    uint64_t burst_left = 0;
+
+    // Uniform - return a double uniform in [0, 1)
+    double Uniform(void) {
+      return static_cast<double>(rng() >> 11) * (1.0 / (uint64_t(1) << 53));
+    }
+
+    // Below - return an integer uniform in [0, @n)
+    uint64_t Below(uint64_t n) {
+      return rng() % n;
+    }
+
+    // Exponential - return an exponential draw with @mean
+    double Exponential(double mean) {
+      return -mean * std::log1p(-Uniform());
+    }
+
+    // NextStart - start time of the next task, nondecreasing
+    uint64_t NextStart(void) {
+      switch (spec.arrivals) {
+        case Arrivals::kPoisson:
+          clock += Exponential(1 / spec.rate);
+          break;
+        case Arrivals::kBursty:
+          // Geometric burst sizes averaging spec.burst; the gap before a
+          // burst keeps the long-run rate at spec.rate
+          if (burst_left == 0) {
+            burst_left = 1;
+            if (spec.burst > 1)
+              burst_left += static_cast<uint64_t>(
+                std::log1p(-Uniform()) / std::log1p(-1.0 / spec.burst));
+            clock += Exponential(spec.burst / spec.rate *
+                                 (kBurstSpeedup - 1) / kBurstSpeedup);
+          }
+          burst_left--;
+          clock += Exponential(1 / (spec.rate * kBurstSpeedup));
+          break;
+        case Arrivals::kBatch:
+          return static_cast<uint64_t>(
+            static_cast<double>(drawn / spec.burst) * spec.burst / spec.rate);
+      }
+      return static_cast<uint64_t>(clock);
+    }
+
+    // NextDuration - duration of the next task, in [1, max_duration]
+    uint64_t NextDuration(void) {
+      double mean = static_cast<double>(spec.mean_duration);
+      double d = 0;
+      switch (spec.durations) {
+        case Durations::kUniform:
+          return 1 + Below(2 * spec.mean_duration - 1);
+        case Durations::kHeavyTail:
+          // Inverse CDF of Pareto(shape 1.5) with mean @mean
+          d = mean / 3 / std::pow(1 - Uniform(), 1 / 1.5);
+          break;
+        case Durations::kBimodal:
+          d = Below(5) ? mean / 2 * Uniform() : mean * (2 + 4 * Uniform());
+          break;
+      }
+      if (d >= static_cast<double>(max_duration))
+        return max_duration;
+      return d < 1 ? 1 : static_cast<uint64_t>(d);
+    }
+};
+
+// writeWorkload - write the task file of @spec to @os
+inline void writeWorkload(const WorkloadSpec& spec, std::ostream& os) {
+  WorkloadGenerator gen(spec);
+  BufferedWriter writer(os);
+  TaskRecord rec;
+  while (gen.Next(rec)) {
+    // id, 2 numbers of at most 20 digits, a nice level & separators
+    writer.Reserve(48);
+    writer.Put(rec.id);
+    writer.Put(' ');
+    writer.PutUInt(rec.start_time);
+    writer.Put(' ');
+    writer.PutUInt(rec.duration);
+    if (spec.nice) {
+      writer.Put(' ');
+      if (rec.nice < 0)
+        writer.Put('-');
+      writer.PutUInt(static_cast<uint64_t>(std::abs(rec.nice)));
+    }
+    writer.Put('\n');
+  }
+  writer.Flush();
+}
+
+#endif  // WORKLOAD_GEN_H_